@@ -2,40 +2,161 @@
 #define APPROXIMATE_COUNT_HPP
 
 #include "hash/hash_family.hpp"
+#include "hash/mix_hash.hpp"
 #include "helper/args.hpp"
 #include "io/fasta.hpp"
+#include "io/mapped_fasta.hpp"
 #include "sketch/hyper_log_log.hpp"
+#include <string>
+#include <string_view>
+#include <vector>
 
 struct Stats {
     std::size_t approximate_kmer_count = 0;
+    // Number of k-mer occurrences, distinct or not
+    std::size_t kmer_count = 0;
     std::size_t sequence_count = 0;
     std::size_t total_length = 0;
 };
 
-template <HashFamily H>
-Stats approximate_count(const ComputeArgs &arg) {
+/**
+ * @brief Estimate of the number of distinct k-mers of the runs it is fed
+ * @tparam H The hash of the k-mers, a single one per k-mer
+ */
+template <Hash H = mix_hash, KmerType KmerT = Kmer>
+class KmerCounter : public io::RunConsumer {
+  public:
+    /**
+     * @param precision The precision of the HyperLogLog, 10 to 18
+     */
+    KmerCounter(std::size_t K, KmerRepr kmer_repr,
+                std::size_t precision = HyperLogLog<H>::default_precision)
+        : hll(kmer_repr, precision), kmer(K) {}
+    void next_sequence() override {
+        kmer.reset();
+        stats.sequence_count++;
+    }
+    void bases(std::string_view,
+               const std::vector<Nucleotide> &bases) override {
+        stats.total_length += bases.size();
+        for (auto n : bases) {
+            kmer.roll(n);
+            if (kmer.available() >= kmer.size()) {
+                hll.update(kmer);
+                stats.kmer_count++;
+            }
+        }
+    }
+    void ambiguous(std::string_view run) override {
+        stats.total_length += run.size();
+        kmer.reset();
+    }
+    void end_sequence() override {}
+    Stats get_stats() const {
+        Stats result = stats;
+        result.approximate_kmer_count = hll.query();
+        return result;
+    }
+
+  private:
+    HyperLogLog<H> hll;
+    KmerT kmer;
     Stats stats;
-    io::FastaReader in(arg.dataset());
-    auto K = arg.k();
-    auto kmer_repr = arg.unidirectional() ? KmerRepr::FORWARD : KmerRepr::CANON;
-    HyperLogLog<H> hll(kmer_repr);
+};
 
-    while (in.next_sequence()) {
-        Kmer kmer(K);
-        char c;
-        stats.sequence_count++;
-        while (in.next_nucleotide(c)) {
-            stats.total_length++;
-            kmer.roll(c);
-            if (kmer.available() >= K) {
+/**
+ * @brief Estimate of the number of distinct k-mers ending in a byte range of
+ * a FASTA file, see io::read_ranges
+ */
+template <Hash H, KmerType KmerT>
+class RangeCounter : public io::RangeConsumer {
+  public:
+    RangeCounter(std::size_t K, KmerRepr kmer_repr, std::size_t precision)
+        : hll(kmer_repr, precision), kmer(K) {}
+    void start(bool first) override {
+        kmer.reset();
+        stats.sequence_count += first;
+    }
+    void bases(const std::vector<Nucleotide> &bases, bool in_range) override {
+        if (!in_range) {
+            for (auto n : bases) {
+                kmer.roll(n);
+            }
+            return;
+        }
+        stats.total_length += bases.size();
+        for (auto n : bases) {
+            kmer.roll(n);
+            if (kmer.available() >= kmer.size()) {
                 hll.update(kmer);
+                stats.kmer_count++;
             }
         }
     }
+    void ambiguous(std::size_t count, bool in_range) override {
+        kmer.reset();
+        stats.total_length += in_range ? count : 0;
+    }
+    /**
+     * @brief Add the counts of the range of another counter
+     */
+    void merge(const RangeCounter &other) {
+        hll.merge(other.hll);
+        stats.kmer_count += other.stats.kmer_count;
+        stats.sequence_count += other.stats.sequence_count;
+        stats.total_length += other.stats.total_length;
+    }
+    Stats get_stats() const {
+        Stats result = stats;
+        result.approximate_kmer_count = hll.query();
+        return result;
+    }
+
+  private:
+    HyperLogLog<H> hll;
+    KmerT kmer;
+    Stats stats;
+};
 
-    stats.approximate_kmer_count = hll.query();
+/**
+ * @brief Estimate the number of distinct k-mers of a FASTA file
+ *
+ * With several threads, each one counts the k-mers ending in its share of the
+ * bytes of the memory-mapped input into its own HyperLogLog. A record split
+ * between threads is continued with the k - 1 bases preceding the split, and
+ * the sketches are merged at the end.
+ * @param precision The precision of the HyperLogLog, 10 to 18
+ */
+template <Hash H = mix_hash, KmerType KmerT = Kmer>
+Stats approximate_count(
+        const std::string &dataset, std::size_t K, KmerRepr kmer_repr,
+        std::size_t precision = HyperLogLog<H>::default_precision,
+        std::size_t threads = 1) {
+    if (threads <= 1) {
+        io::FastaReader in(dataset);
+        KmerCounter<H, KmerT> counter(K, kmer_repr, precision);
+        io::read_runs(in, {&counter});
+        return counter.get_stats();
+    }
+    io::MappedFile file(dataset);
+    std::vector<RangeCounter<H, KmerT>> counters(
+            threads, RangeCounter<H, KmerT>(K, kmer_repr, precision));
+    std::vector<std::vector<io::RangeConsumer *>> consumers;
+    for (auto &counter : counters) {
+        consumers.push_back({&counter});
+    }
+    io::read_ranges(file, K - 1, consumers);
+    for (std::size_t t = 1; t < threads; t++) {
+        counters[0].merge(counters[t]);
+    }
+    return counters[0].get_stats();
+}
 
-    return stats;
+template <Hash H = mix_hash, KmerType KmerT = Kmer>
+Stats approximate_count(const ComputeArgs &arg) {
+    auto kmer_repr = arg.unidirectional() ? KmerRepr::FORWARD : KmerRepr::CANON;
+    return approximate_count<H, KmerT>(arg.dataset(), arg.k(), kmer_repr,
+                                       arg.hll_precision(), arg.threads());
 }
 
 #endif
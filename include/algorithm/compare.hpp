@@ -0,0 +1,28 @@
+#ifndef COMPARE_HPP
+#define COMPARE_HPP
+
+#include "algorithm/exact.hpp"
+#include "helper/args.hpp"
+
+namespace compare {
+
+/**
+ * @brief Compute the accuracy by sorting the present k-mers of both files
+ *
+ * The present k-mers are extracted in parallel into flat arrays, radix sorted
+ * and merge-joined. Unlike exact::compute_accuracy, this also reports how many
+ * times the k-mers of the output are represented.
+ * @tparam KmerT The k-mer type, instantiated for the types of with_kmer_size
+ */
+template <KmerType KmerT = Kmer>
+exact::Accuracy sorted_accuracy(const CompareArgs &args);
+
+/**
+ * @brief Fraction of k-mers to compare so that the memory budget is kept
+ * @param full_memory Memory in bytes needed to compare all k-mers
+ */
+double sample_rate(const CompareArgs &args, std::size_t full_memory);
+
+} // namespace compare
+
+#endif
@@ -2,6 +2,8 @@
 #define EXACT_HPP
 
 #include "helper/args.hpp"
+#include "helper/kmer.hpp"
+#include <vector>
 
 namespace exact {
 
@@ -9,10 +11,23 @@ struct Accuracy {
     std::size_t missing_kmers = 0;
     std::size_t additional_kmers = 0;
     std::size_t present_kmers = 0;
+    // Number of distinct k-mers of the output represented exactly i times,
+    // the last entry counts all higher multiplicities. Empty if not computed.
+    std::vector<std::size_t> multiplicity;
+    // Fraction of k-mers the counts were computed on
+    double sample_rate = 1;
 };
 
+/**
+ * @tparam KmerT The k-mer type, instantiated for the types of with_kmer_size
+ */
+template <KmerType KmerT = Kmer>
 Accuracy compute_accuracy(const CompareArgs &args);
 
+/**
+ * @tparam KmerT The k-mer type, instantiated for the types of with_kmer_size
+ */
+template <KmerType KmerT = Kmer>
 int compute_superstring(const ExactArgs &args);
 } // namespace exact
 
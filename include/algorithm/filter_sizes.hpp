@@ -0,0 +1,32 @@
+#ifndef FILTER_SIZES_HPP
+#define FILTER_SIZES_HPP
+
+#include "helper/args.hpp"
+#include <cstddef>
+
+/**
+ * @brief Numbers of bits of the filters of both phases of the streaming
+ * algorithm
+ */
+struct FilterSizes {
+    std::size_t first_phase = 0;
+    std::size_t second_phase = 0;
+};
+
+/**
+ * @brief Size the filters by bits per k-mer, or to fit into the memory budget
+ *
+ * Without --fused, the filters of the two phases are never allocated at once
+ * and each gets the whole budget. With --fused, the budget is split so that
+ * both filters get the same number of cells per element and thus the same
+ * error rate. Within a budget, no filter gets more than MAX_BITS_PER_ELEMENT
+ * cells per element.
+ * @param kmers Approximate number of distinct k-mers
+ * @param duplicates Approximate number of repeated k-mer occurrences
+ * @param cell_bits Bits the second phase filter spends per cell of a Bloom
+ * filter of the same error rate, the bits per counter of a counting one
+ */
+FilterSizes filter_sizes(const ComputeArgs &args, std::size_t kmers,
+                         std::size_t duplicates, double cell_bits);
+
+#endif
@@ -3,53 +3,222 @@
 
 #include "hash/hash_family.hpp"
 #include "helper/args.hpp"
+#include "helper/kmer_cache.hpp"
 #include "io/fasta.hpp"
 #include "sketch/bloom_filter.hpp"
+#include "sketch/counting_bloom_filter.hpp"
+#include <array>
+#include <concepts>
+#include <optional>
 #include <iostream>
+#include <string_view>
+#include <vector>
 
 namespace first_phase {
 
-template <RollingHashFamily H>
-int compute_superstring(std::size_t approx_set_size, const ComputeArgs &args) {
-    using BF = RollingBloomFilter<H>;
-    auto K = args.k();
-    bool splice = args.splice() && !args.second_phase();
-    io::FastaReader in(args.dataset());
-    io::KmerWriter out(args.first_phase_output(), K, splice);
-    auto kmer_repr =
-            args.unidirectional() ? KmerRepr::FORWARD : KmerRepr::CANON;
-    out.write_header(args.fasta_header());
-    BF filter =
-            BF::optimal(approx_set_size, args.bits_per_element(), K, kmer_repr);
-
-    if (args.verbose()) {
-        std::size_t size_kb = filter.size() / (1024 * 8);
-        double error_rate = filter.error_rate(approx_set_size);
-        std::cerr << "[Bloom Filter with size " << size_kb
-                  << " KB, expected error rate " << error_rate * 100 << "%]\n";
-    }
-
-    while (in.next_sequence()) {
-        std::size_t read = 0;
-        char c;
-        filter.reset_hash_family();
-        for (std::size_t i = 0; i < K - 1 && in.next_nucleotide(c); i++) {
-            filter.roll(c);
-            out.add_nucleotide(c);
-        }
-        while (in.next_nucleotide(c)) {
-            filter.roll(c);
-            out.add_nucleotide(c);
-            bool first_occurence = !filter.contains_this();
-            if (first_occurence) {
-                filter.insert_this();
-                out.print_nucleotide(io::PRESENT);
-            } else {
-                out.print_nucleotide(io::NOT_PRESENT);
+/**
+ * @brief A rolling filter of the k-mers seen so far
+ */
+template <class F>
+concept Filter = requires(F filter, const F cfilter, Nucleotide n,
+                          std::size_t size, std::size_t *probe) {
+    { F::for_size(size, size, size, KmerRepr::CANON) } -> std::same_as<F>;
+    { F::name() } -> std::convertible_to<const char *>;
+    filter.reset_hash_family();
+    filter.roll(n);
+    filter.insert_this();
+    { cfilter.contains_this() } -> std::same_as<bool>;
+    { cfilter.probe_size() } -> std::convertible_to<std::size_t>;
+    cfilter.prefetch_this(probe);
+    { cfilter.contains_probe(probe) } -> std::same_as<bool>;
+    filter.insert_probe(probe);
+    { cfilter.hashes() } -> std::convertible_to<std::size_t>;
+    { cfilter.size() } -> std::convertible_to<std::size_t>;
+    { cfilter.error_rate(size) } -> std::convertible_to<double>;
+    { cfilter.fill_ratio() } -> std::convertible_to<double>;
+};
+
+/**
+ * @brief The first phase of the streaming algorithm over the runs it is fed
+ *
+ * The filter is rolled LOOKAHEAD bases ahead of the k-mer being processed, and
+ * the probe of every k-mer is prefetched when it is rolled in, so that the
+ * random accesses of consecutive k-mers overlap. The k-mers are still tested
+ * and inserted in order, so the output does not depend on the lookahead.
+ * @tparam KmerT The k-mer type, of a fixed size if known at compile time
+ * @tparam BF The filter of the k-mers seen so far
+ * @tparam Missing The second phase filter of a fused run
+ */
+template <RollingHashFamily H, KmerType KmerT = Kmer,
+          Filter BF = RollingBloomFilter<H>,
+          class Missing = RollingCountingBloomFilter<H>>
+class Pipeline : public io::RunConsumer {
+  public:
+    /**
+     * @param filter_size Number of bits of the filter
+     * @param missing If not null, every k-mer marked as not present is also
+     * inserted into this filter, replacing the first pass of the second phase
+     */
+    Pipeline(std::size_t approx_set_size, std::size_t filter_size,
+             const ComputeArgs &args, Missing *missing = nullptr)
+        : K(KmerT::fixed_size ? KmerT::fixed_size : args.k()),
+          out(args.first_phase_output(), K,
+              args.splice() && !args.second_phase()),
+          filter(BF::for_size(approx_set_size, filter_size, K,
+                              args.unidirectional() ? KmerRepr::FORWARD
+                                                    : KmerRepr::CANON)),
+          missing(missing), kmer(K),
+          repr(args.unidirectional() ? KmerRepr::FORWARD : KmerRepr::CANON) {
+        if (args.kmer_cache()) {
+            cache.emplace();
+        }
+        out.write_header(args.fasta_header());
+        if (args.verbose()) {
+            std::size_t size_kb = filter.size() / (1024 * 8);
+            double error_rate = filter.error_rate(approx_set_size);
+            std::cerr << "[" << BF::name() << " with size " << size_kb
+                      << " KB, " << filter.hashes()
+                      << " hashes, expected error rate " << error_rate * 100
+                      << "%]\n";
+        }
+    }
+    void next_sequence() override { restart(); }
+    void bases(std::string_view,
+               const std::vector<Nucleotide> &bases) override {
+        for (auto n : bases) {
+            if (pending == LOOKAHEAD) {
+                process_oldest();
+            }
+            std::size_t slot = (oldest + pending) % LOOKAHEAD;
+            filter.roll(n);
+            if (++rolled >= K) {
+                filter.prefetch_this(probe(slot));
             }
+            pending_bases[slot] = n;
+            pending++;
         }
+    }
+    void ambiguous(std::string_view run) override {
+        // No k-mer spans an ambiguous run, start over after it
+        drain();
+        out.flush();
+        out.print_ambiguous(run);
+        restart();
+    }
+    void end_sequence() override {
+        drain();
         out.flush();
     }
+    const BF &get_filter() const { return filter; }
+    /**
+     * @brief Number of k-mer occurrences marked as not present so far
+     */
+    std::size_t marked_not_present() const { return not_present; }
+    /**
+     * @brief Number of lowercase bases written so far, an upper bound on the
+     * k-mers the first pass of the second phase inserts, including those
+     * spanning the end of a sequence
+     */
+    std::size_t lowercase_written() const { return out.lowercase(); }
+    /**
+     * @brief Fraction of k-mers found in the cache of recent k-mers, zero
+     * without the cache
+     */
+    double cache_hit_rate() const { return cache ? cache->hit_rate() : 0; }
+
+  private:
+    /**
+     * @brief Number of bases the filter is rolled ahead, enough to cover the
+     * memory latency with the work of the k-mers in between
+     */
+    static constexpr std::size_t LOOKAHEAD = 16;
+
+    std::size_t *probe(std::size_t slot) {
+        return probes.data() + slot * filter.probe_size();
+    }
+    /**
+     * @brief Test and insert the k-mer ending at the oldest pending base
+     */
+    void process_oldest() {
+        auto n = pending_bases[oldest];
+        auto *p = probe(oldest);
+        oldest = (oldest + 1) % LOOKAHEAD;
+        pending--;
+        if (missing) {
+            missing->roll(n);
+        }
+        out.add_nucleotide(n);
+        if (cache) {
+            kmer.roll(n);
+        }
+        if (++read < K) {
+            return;
+        }
+        // A cached k-mer was inserted or found before, the filter contains it
+        bool first_occurence =
+                !(cache && cache->test_and_set(kmer.data(repr))) &&
+                !filter.contains_probe(p);
+        if (first_occurence) {
+            filter.insert_probe(p);
+            out.print_nucleotide(io::PRESENT);
+        } else {
+            if (missing) {
+                missing->insert_this();
+            }
+            not_present++;
+            out.print_nucleotide(io::NOT_PRESENT);
+        }
+    }
+    void drain() {
+        while (pending > 0) {
+            process_oldest();
+        }
+    }
+    void restart() {
+        read = 0;
+        rolled = 0;
+        oldest = 0;
+        pending = 0;
+        kmer.reset();
+        filter.reset_hash_family();
+        if (missing) {
+            missing->reset_hash_family();
+        }
+    }
+
+    std::size_t K;
+    io::BasicKmerWriter<KmerT> out;
+    BF filter;
+    Missing *missing;
+    std::size_t read = 0;
+    std::size_t rolled = 0;
+    std::array<Nucleotide, LOOKAHEAD> pending_bases;
+    std::vector<std::size_t> probes =
+        std::vector<std::size_t>(LOOKAHEAD * filter.probe_size());
+    std::size_t oldest = 0;
+    std::size_t pending = 0;
+    std::size_t not_present = 0;
+    std::optional<KmerCache<typename KmerT::data_t>> cache;
+    KmerT kmer;
+    KmerRepr repr;
+};
+
+/**
+ * @brief Run the first phase of the streaming algorithm
+ * @param filter_size Number of bits of the filter
+ * @param missing If not null, every k-mer marked as not present is also
+ * inserted into this filter, replacing the first pass of the second phase
+ * @tparam KmerT The k-mer type, of a fixed size if known at compile time
+ */
+template <RollingHashFamily H, KmerType KmerT = Kmer,
+          Filter BF = RollingBloomFilter<H>,
+          class Missing = RollingCountingBloomFilter<H>>
+int compute_superstring(std::size_t approx_set_size, std::size_t filter_size,
+                        const ComputeArgs &args, Missing *missing = nullptr) {
+    io::FastaReader in(args.dataset());
+    Pipeline<H, KmerT, BF, Missing> pipeline(approx_set_size, filter_size,
+                                             args, missing);
+    io::read_runs(in, {&pipeline});
     return 0;
 }
 } // namespace first_phase
@@ -4,82 +4,167 @@
 #include "hash/hash_family.hpp"
 #include "helper/args.hpp"
 #include "io/fasta.hpp"
-#include "sketch/counting_bloom_filter.hpp"
 #include <cctype>
+#include <concepts>
 #include <iostream>
+#include <string_view>
+#include <vector>
 
 namespace second_phase {
 
-template <RollingHashFamily H>
-int compute_superstring(std::size_t approx_set_size, const ComputeArgs &arg) {
-    using CBF = RollingCountingBloomFilter<H>;
-    auto K = arg.k();
-    io::FastaReader in(arg.first_phase_output());
-    io::KmerWriter out(arg.second_phase_output(), K, arg.splice());
+/**
+ * @brief A rolling filter of the k-mers missing from the first phase output,
+ * supporting deletions
+ */
+template <class F>
+concept Filter = requires(F filter, const F cfilter, Nucleotide n,
+                          std::size_t size) {
+    { F::for_memory(size, size, size, KmerRepr::CANON) } -> std::same_as<F>;
+    { F::name() } -> std::convertible_to<const char *>;
+    filter.reset_hash_family();
+    filter.roll(n);
+    filter.insert_this();
+    filter.erase_this();
+    { cfilter.contains_this() } -> std::same_as<bool>;
+    { cfilter.hashes() } -> std::convertible_to<std::size_t>;
+    { cfilter.memory() } -> std::convertible_to<std::size_t>;
+    { cfilter.error_rate(size) } -> std::convertible_to<double>;
+    { cfilter.overflows() } -> std::convertible_to<std::size_t>;
+};
+
+/**
+ * @brief Whether F stores the k-mers exactly, without false positives
+ */
+template <class F>
+constexpr bool is_exact = requires { requires F::exact; };
+
+/**
+ * @param filter_size Number of bits of the filter
+ */
+template <Filter F>
+F create_filter(std::size_t approx_set_size, std::size_t filter_size,
+                const ComputeArgs &arg) {
     auto repr = arg.unidirectional() ? KmerRepr::FORWARD : KmerRepr::CANON;
-    CBF filter = CBF::optimal(approx_set_size, arg.bits_per_element(), arg.k(),
-                              repr);
+    F filter = F::for_memory(approx_set_size, filter_size, arg.k(), repr);
 
-    if (arg.verbose()) {
-        std::size_t size_kb = filter.size() / (1024 * 8);
+    if (arg.verbose() && is_exact<F>) {
+        std::cerr << "[Exact correction with an " << F::name() << " of "
+                  << filter.memory() / 1024 << " KB for " << approx_set_size
+                  << " k-mers]\n";
+    } else if (arg.verbose()) {
+        std::size_t size_kb = filter.memory() / 1024;
         double error_rate = filter.error_rate(approx_set_size);
-        std::cerr << "[Couting Bloom Filter with size " << size_kb << " KB, "
-                  << "expected error rate " << error_rate * 100 << "%]\n";
+        std::cerr << "[" << F::name() << " with size " << size_kb << " KB, "
+                  << filter.hashes() << " hashes, expected error rate "
+                  << error_rate * 100 << "%]\n";
     }
+    return filter;
+}
 
-    in.reset();
+/**
+ * @brief Run the second and third pass of the second phase over the first
+ * phase output. The filter must already contain the k-mers marked as not
+ * present, either from the first pass or from a fused first phase.
+ * @tparam KmerT The k-mer type, of a fixed size if known at compile time
+ */
+template <Filter F, KmerType KmerT = Kmer>
+int correct_superstring(F &filter, const ComputeArgs &arg) {
+    std::size_t K = KmerT::fixed_size ? KmerT::fixed_size : arg.k();
+    io::FastaReader in(arg.first_phase_output());
+    io::BasicKmerWriter<KmerT> out(arg.second_phase_output(), K,
+                                    arg.splice());
+    if (arg.verbose() && !is_exact<F>) {
+        std::cerr << "[" << F::name() << " overflow table with "
+                  << filter.overflows() << " entries]\n";
+    }
+
+    std::string_view run;
+    std::vector<Nucleotide> bases;
+    filter.reset_hash_family();
     while (in.next_sequence()) {
-        char c;
         std::uint64_t mask = 0;
-        while (in.next_nucleotide(c)) {
-            filter.roll(c);
-            mask = (mask << 1) | (bool)std::islower(c);
-            mask &= (1ULL << K) - 1;
-            if (mask & (1ULL << (K - 1))) {
-                filter.insert_this();
+        while (in.next_bases(run, bases)) {
+            if (in.ambiguous()) {
+                filter.reset_hash_family();
+                mask = 0;
+                continue;
+            }
+            for (std::size_t i = 0; i < bases.size(); i++) {
+                filter.roll(bases[i]);
+                mask = (mask << 1) | (bool)std::isupper(run[i]);
+                if (mask & (1ULL << (K - 1))) {
+                    filter.erase_this();
+                }
             }
         }
     }
 
     in.reset();
+    out.write_header(arg.fasta_header() + " (second phase)");
     while (in.next_sequence()) {
-        char c;
         std::uint64_t mask = 0;
-        while (in.next_nucleotide(c)) {
-            filter.roll(c);
-            mask = (mask << 1) | (bool)std::isupper(c);
-            mask &= (1ULL << K) - 1;
-            if (mask & (1ULL << (K - 1))) {
+        std::size_t read = 0;
+        while (in.next_bases(run, bases)) {
+            if (in.ambiguous()) {
+                out.flush();
+                out.print_ambiguous(run);
+                filter.reset_hash_family();
+                mask = 0;
+                read = 0;
+                continue;
+            }
+            for (std::size_t i = 0; i < bases.size(); i++) {
+                filter.roll(bases[i]);
+                read++;
+                mask = (mask << 1) | (bool)std::isupper(run[i]);
+                out.add_nucleotide(bases[i]);
+                if (read < K) {
+                    continue;
+                }
+                if (mask & (1ULL << (K - 1)) || filter.contains_this()) {
+                    out.print_nucleotide(io::PRESENT);
+                } else {
+                    out.print_nucleotide(io::NOT_PRESENT);
+                }
                 filter.erase_this();
             }
         }
+        out.flush();
     }
+    return 0;
+}
 
-    in.reset();
-    out.write_header(arg.fasta_header() + " (second phase)");
+/**
+ * @param filter_size Number of bits of the filter
+ */
+template <Filter F, KmerType KmerT = Kmer>
+int compute_superstring(std::size_t approx_set_size, std::size_t filter_size,
+                        const ComputeArgs &arg) {
+    std::size_t K = KmerT::fixed_size ? KmerT::fixed_size : arg.k();
+    io::FastaReader in(arg.first_phase_output());
+    auto filter = create_filter<F>(approx_set_size, filter_size, arg);
+
+    std::string_view run;
+    std::vector<Nucleotide> bases;
     while (in.next_sequence()) {
-        char c;
         std::uint64_t mask = 0;
-        std::size_t read = 0;
-        while (in.next_nucleotide(c)) {
-            filter.roll(c);
-            read++;
-            mask = (mask << 1) | (bool)std::isupper(c);
-            mask &= (1ULL << K) - 1;
-            out.add_nucleotide(c);
-            if (read < K) {
+        while (in.next_bases(run, bases)) {
+            if (in.ambiguous()) {
+                filter.reset_hash_family();
+                mask = 0;
                 continue;
             }
-            if (mask & (1ULL << (K - 1)) || filter.contains_this()) {
-                out.print_nucleotide(io::PRESENT);
-            } else {
-                out.print_nucleotide(io::NOT_PRESENT);
+            for (std::size_t i = 0; i < bases.size(); i++) {
+                filter.roll(bases[i]);
+                mask = (mask << 1) | (bool)std::islower(run[i]);
+                if (mask & (1ULL << (K - 1))) {
+                    filter.insert_this();
+                }
             }
-            filter.erase_this();
         }
-        out.flush();
     }
-    return 0;
+
+    return correct_superstring<F, KmerT>(filter, arg);
 }
 
 } // namespace second_phase
@@ -9,7 +9,8 @@ template <class T>
 class hash_family {
   public:
     using hash_t = std::uint64_t;
-    std::span<const hash_t> hash(const Kmer &kmer) {
+    template <KmerType K>
+    std::span<const hash_t> hash(const K &kmer) {
         return static_cast<T *>(this)->hash_impl(kmer);
     }
     hash_family(std::size_t nhashes) : nhashes(nhashes) {
@@ -37,10 +38,15 @@ class rolling_hash_family : public hash_family<T> {
     using hash_t = std::uint64_t;
 
     rolling_hash_family(std::size_t nhashes) : hash_family<T>(nhashes) {}
-    void roll(char c) { static_cast<T *>(this)->roll_impl(c); }
-    void init(const Kmer &kmer) { static_cast<T *>(this)->init_impl(kmer); }
+    void roll(char c) { roll(char_to_nucleotide(c)); }
+    void roll(Nucleotide n) { static_cast<T *>(this)->roll_impl(n); }
+    template <KmerType K>
+    void init(const K &kmer) {
+        static_cast<T *>(this)->init_impl(kmer);
+    }
     void reset() { static_cast<T *>(this)->reset_impl(); }
-    std::span<const hash_t> hash_impl(const Kmer &kmer) {
+    template <KmerType K>
+    std::span<const hash_t> hash_impl(const K &kmer) {
         static_cast<T *>(this)->init(kmer);
         return static_cast<T *>(this)->get_hashes();
     }
@@ -83,7 +89,7 @@ concept RollingHash = T::rolling && requires(T t) {
 template <class T>
 concept RollingHashFamily =
         std::derived_from<T, rolling_hash_family<T>> && requires(T t) {
-            { t.roll_impl(std::declval<char>()) } -> std::same_as<void>;
+            { t.roll_impl(std::declval<Nucleotide>()) } -> std::same_as<void>;
             { t.init_impl(std::declval<const Kmer &>()) } -> std::same_as<void>;
             { t.reset_impl() } -> std::same_as<void>;
         };
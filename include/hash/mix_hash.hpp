@@ -0,0 +1,46 @@
+#ifndef MIX_HASH_HPP
+#define MIX_HASH_HPP
+
+#include "hash_family.hpp"
+
+/**
+ * @brief A single 64-bit hash of a k-mer by the MurMur3 finalizer
+ *
+ * The finalizer is a bijection of 64-bit integers in which every input bit
+ * affects every output bit, so it hashes the 2-bit encoding of a k-mer of up
+ * to 32 bases without loss. Wider k-mers are folded to 64 bits first. It costs
+ * two multiplications per k-mer, several times less than a full MurMur hash.
+ */
+class mix_hash {
+  public:
+    static constexpr bool rolling = false;
+    using hash_t = std::uint64_t;
+    mix_hash(std::uint64_t seed, KmerRepr repr) : _seed(seed), repr(repr) {}
+    template <KmerType K>
+    hash_t hash(const K &key) const {
+        const auto &data = key.data(repr);
+        std::uint64_t x = data;
+        if constexpr (sizeof(data) > sizeof(x)) {
+            x ^= mix(data >> 64);
+        }
+        return mix(x ^ _seed);
+    }
+    std::uint64_t seed() const { return _seed; }
+
+  private:
+    static std::uint64_t mix(std::uint64_t x) {
+        x ^= x >> 33;
+        x *= 0xff51afd7ed558ccdULL;
+        x ^= x >> 33;
+        x *= 0xc4ceb9fe1a85ec53ULL;
+        x ^= x >> 33;
+        return x;
+    }
+
+    std::uint64_t _seed;
+    KmerRepr repr;
+};
+
+static_assert(Hash<mix_hash>);
+
+#endif
@@ -3,12 +3,19 @@
 
 #include "hash_family.hpp"
 
+std::uint64_t murmur_hash_impl(const void *data, std::size_t size,
+                               std::size_t seed);
+
 class murmur_hash {
   public:
     static constexpr bool rolling = false;
     using hash_t = std::uint64_t;
     murmur_hash(std::uint64_t seed, KmerRepr repr) : _seed(seed), repr(repr) {}
-    hash_t hash(const Kmer &key) const;
+    template <KmerType K>
+    hash_t hash(const K &key) const {
+        return murmur_hash_impl(&key.data(repr), sizeof(key.data(repr)),
+                                _seed);
+    }
     std::uint64_t seed() const { return _seed; }
 
   private:
@@ -21,7 +28,15 @@ class murmur_hash_family : public hash_family<murmur_hash_family> {
   public:
     murmur_hash_family(std::size_t nhashes, KmerRepr repr);
     murmur_hash_family(std::size_t nhashes, std::uint64_t seed, KmerRepr repr);
-    std::span<const hash_t> hash_impl(const Kmer &kmer);
+    template <KmerType K>
+    std::span<const hash_t> hash_impl(const K &kmer) {
+        auto x = xhash.hash(kmer);
+        auto y = yhash.hash(kmer);
+        for (std::size_t i = 0; i < nhashes; i++) {
+            buffer[i] = x + i * y;
+        }
+        return std::span(buffer.get(), nhashes);
+    }
 
   private:
     murmur_hash xhash, yhash;
@@ -18,30 +18,89 @@ class poly_hash {
     }
     hash_t get_hash(bool reverse) const { return reverse ? rev_state : state; };
     void roll(Nucleotide n_in, Nucleotide n_out);
-    void init(const Kmer &kmer);
+    template <KmerType K>
+    void init(const K &kmer) {
+        set_size(kmer.size());
+        for (int i = kmer.size() - 1; i >= 0; i--) {
+            auto nucleotide = kmer.get(i, KmerRepr::FORWARD);
+            auto rnucleotide = kmer.get(i, KmerRepr::REVERSE);
+            state = mod.reduce2((uint128_t)state * p + NVALUE[nucleotide]);
+            rev_state =
+                    mod.reduce2((uint128_t)rev_state * p + NVALUE[rnucleotide]);
+        }
+        state = mod.reduce(state);
+        rev_state = mod.reduce(rev_state);
+    }
     void reset();
 
   private:
+    static constexpr std::uint64_t NVALUE[] = {1, 2, 3, 4, 0};
+    /**
+     * @brief Reset the state for k-mers of size k
+     */
+    void set_size(std::size_t k);
     std::uint64_t p, inv_p, state, rev_state, last_exp;
     std::size_t k;
     Modulus mod;
 };
 
-class poly_hash_family : public rolling_hash_family<poly_hash_family> {
+/**
+ * @brief Rolling hash family of two polynomial hashes combined by double
+ * hashing, tracking the current k-mer as a `KmerT`
+ */
+template <KmerType KmerT = Kmer>
+class basic_poly_hash_family
+    : public rolling_hash_family<basic_poly_hash_family<KmerT>> {
+    using Base = rolling_hash_family<basic_poly_hash_family<KmerT>>;
+    using Base::buffer;
+    using Base::nhashes;
+
   public:
-    poly_hash_family(std::size_t nhashes, std::size_t k, KmerRepr repr);
-    poly_hash_family(std::size_t nhashes, KmerRepr repr);
-    void roll_impl(char c);
-    void init_impl(const Kmer &kmer);
-    void reset_impl();
+    basic_poly_hash_family(std::size_t nhashes, std::size_t k, KmerRepr repr)
+        : Base(nhashes), xhash(k, 0), yhash(k, 1), repr(repr), kmer(k) {}
+    basic_poly_hash_family(std::size_t nhashes, KmerRepr repr)
+        : basic_poly_hash_family(nhashes, KmerT::fixed_size, repr) {}
+    void roll_impl(Nucleotide n_in) {
+        Nucleotide n_out = kmer.last(KmerRepr::FORWARD);
+        kmer.roll(n_in);
+        xhash.roll(n_in, n_out);
+        yhash.roll(n_in, n_out);
+
+        update_hashes();
+    }
+    template <KmerType K>
+    void init_impl(const K &key) {
+        kmer = KmerT(key.size());
+        for (std::size_t i = key.available(); i-- > 0;) {
+            kmer.roll(key.get(i));
+        }
+        xhash.init(key);
+        yhash.init(key);
+
+        update_hashes();
+    }
+    void reset_impl() {
+        xhash.reset();
+        yhash.reset();
+        kmer.reset();
+    }
 
   private:
-    void update_hashes();
+    void update_hashes() {
+        bool use_reverse = kmer.use_reverse(repr);
+        auto x = xhash.get_hash(use_reverse);
+        auto y = yhash.get_hash(use_reverse);
+        for (std::size_t i = 0; i < nhashes; i++) {
+            buffer[i] = x + i * y;
+        }
+    }
     poly_hash xhash, yhash;
     KmerRepr repr;
-    Kmer kmer;
+    KmerT kmer;
 };
 
+using poly_hash_family = basic_poly_hash_family<>;
+
 static_assert(RollingHash<poly_hash>);
 static_assert(RollingHashFamily<poly_hash_family>);
 
@@ -1,19 +1,80 @@
 #ifndef ARGS_HPP
 #define ARGS_HPP
 
+#include "helper/page_memory.hpp"
 #include <optional>
 #include <string>
+#include <vector>
+
+/**
+ * @brief The filter of the k-mers seen in the first phase
+ */
+enum class FirstPhaseFilter {
+    BLOOM,
+    CUCKOO,
+};
+
+/**
+ * @brief The filter of the k-mers missing from the first phase output
+ */
+enum class SecondPhaseFilter {
+    COUNTING_BLOOM,
+    DLEFT,
+};
 
 class ComputeArgs {
   public:
     static std::optional<ComputeArgs> from_cmdline(int argc, std::string *argv);
     static int usage();
-    std::size_t k() const { return _k; }
+    std::size_t k() const { return _ks.front(); }
+    /**
+     * @brief All k-mer sizes to compute a superstring for in one batch
+     */
+    const std::vector<std::size_t> &ks() const { return _ks; }
+    /**
+     * @brief The arguments of the batch for the k-mer size `k`. With several
+     * sizes, ".k<size>" is inserted before the extension of the output files.
+     */
+    ComputeArgs for_k(std::size_t k) const;
     std::size_t bits_per_element() const { return _bpk; }
+    /**
+     * @brief Memory budget in bytes for the filters, zero if they are sized
+     * by bits_per_element. In a batch, every k-mer size gets an equal share.
+     */
+    std::size_t memory() const { return _memory; }
     bool unidirectional() const { return _unidirectional; }
     bool splice() const { return !_no_splice; }
     bool second_phase() const { return !_skip_second_phase; }
-    bool verbose() const { return _verbose; }
+    bool fused() const { return _fused && !_skip_second_phase; }
+    /**
+     * @brief Whether to correct with an exact k-mer set instead of the filter
+     * when the k-mers marked as not present fit into its memory, never fused
+     */
+    bool exact_correction() const { return _exact_correction && !fused(); }
+    /**
+     * @brief Whether the first phase looks up recent k-mers in a small cache
+     * before its filter
+     */
+    bool kmer_cache() const { return _kmer_cache; }
+    /**
+     * @brief Whether to report the filter sizes, always with a memory budget
+     */
+    bool verbose() const { return _verbose || _memory > 0; }
+    HugePages huge_pages() const { return _huge_pages; }
+    FirstPhaseFilter first_phase_filter() const { return _first_filter; }
+    SecondPhaseFilter second_phase_filter() const { return _second_filter; }
+    /**
+     * @brief Bits per counter of the counting Bloom filter, 3 or 4
+     */
+    std::size_t counter_bits() const { return _counter_bits; }
+    /**
+     * @brief Number of bits selecting a HyperLogLog register, 10 to 18
+     */
+    std::size_t hll_precision() const { return _hll_precision; }
+    /**
+     * @brief Number of threads estimating the number of k-mers
+     */
+    std::size_t threads() const { return _threads; }
     const std::string &dataset() const { return _dataset; }
     const std::string &first_phase_output() const { return _first_out; }
     const std::string &second_phase_output() const { return _second_out; }
@@ -21,19 +82,39 @@ class ComputeArgs {
     std::string fasta_header() const;
 
   private:
-    ComputeArgs(std::size_t k, std::size_t bpk, bool unidirectional,
-                bool splice, bool skip_second, bool verbose,
-                std::string &&dataset, std::string &&first_out,
-                std::string &&second_out)
-        : _k(k), _bpk(bpk), _unidirectional(unidirectional), _no_splice(splice),
-          _skip_second_phase(skip_second), _verbose(verbose),
-          _dataset(std::move(dataset)), _first_out(std::move(first_out)),
+    ComputeArgs(std::vector<std::size_t> &&ks, std::size_t bpk,
+                std::size_t memory, HugePages huge_pages,
+                FirstPhaseFilter first_filter, SecondPhaseFilter second_filter,
+                std::size_t counter_bits, std::size_t hll_precision,
+                std::size_t threads, bool unidirectional, bool splice,
+                bool skip_second, bool fused, bool exact_correction,
+                bool kmer_cache, bool verbose, std::string &&dataset,
+                std::string &&first_out, std::string &&second_out)
+        : _ks(std::move(ks)), _bpk(bpk), _memory(memory),
+          _huge_pages(huge_pages), _first_filter(first_filter),
+          _second_filter(second_filter), _counter_bits(counter_bits),
+          _hll_precision(hll_precision), _threads(threads),
+          _unidirectional(unidirectional), _no_splice(splice),
+          _skip_second_phase(skip_second), _fused(fused),
+          _exact_correction(exact_correction), _kmer_cache(kmer_cache),
+          _verbose(verbose), _dataset(std::move(dataset)),
+          _first_out(std::move(first_out)),
           _second_out(std::move(second_out)) {}
-    std::size_t _k;
+    std::vector<std::size_t> _ks;
     std::size_t _bpk;
+    std::size_t _memory;
+    HugePages _huge_pages;
+    FirstPhaseFilter _first_filter;
+    SecondPhaseFilter _second_filter;
+    std::size_t _counter_bits;
+    std::size_t _hll_precision;
+    std::size_t _threads;
     bool _unidirectional;
     bool _no_splice;
     bool _skip_second_phase;
+    bool _fused;
+    bool _exact_correction;
+    bool _kmer_cache;
     bool _verbose;
     std::string _dataset;
     std::string _first_out;
@@ -46,23 +127,35 @@ class ExactArgs {
     static int usage();
 
     std::size_t k() const { return _k; }
+    std::size_t threads() const { return _threads; }
+    /**
+     * @brief Memory budget in bytes, zero if the k-mer set is kept in memory
+     */
+    std::size_t memory() const { return _memory; }
     bool unidirectional() const { return _unidirectional; }
     bool splice() const { return !_no_splice; }
     const std::string &dataset() const { return _dataset; }
     const std::string &output() const { return _output; }
+    const std::string &tmp_prefix() const { return _tmp; }
 
     std::string fasta_header() const;
 
   private:
-    ExactArgs(std::size_t k, bool unidirectional, bool splice,
-              std::string &&dataset, std::string &&output)
-        : _k(k), _unidirectional(unidirectional), _no_splice(splice),
-          _dataset(std::move(dataset)), _output(std::move(output)) {}
+    ExactArgs(std::size_t k, std::size_t threads, std::size_t memory,
+              bool unidirectional, bool splice, std::string &&dataset,
+              std::string &&output, std::string &&tmp)
+        : _k(k), _threads(threads), _memory(memory),
+          _unidirectional(unidirectional), _no_splice(splice),
+          _dataset(std::move(dataset)), _output(std::move(output)),
+          _tmp(std::move(tmp)) {}
     std::size_t _k;
+    std::size_t _threads;
+    std::size_t _memory;
     bool _unidirectional;
     bool _no_splice;
     std::string _dataset;
     std::string _output;
+    std::string _tmp;
 };
 
 class CompareArgs {
@@ -71,19 +164,47 @@ class CompareArgs {
     static int usage();
 
     std::size_t k() const { return _k; }
+    std::size_t threads() const { return _threads; }
     bool unidirectional() const { return _unidirectional; }
+    bool sort() const { return _sort; }
+    /**
+     * @brief Fraction of k-mers to compare, 1 to compare all of them
+     */
+    double sample_rate() const { return _sample_rate; }
+    /**
+     * @brief Memory budget in bytes bounding the sample rate, zero if unbounded
+     */
+    std::size_t memory() const { return _memory; }
     const std::string &output() const { return _output; }
     const std::string &golden() const { return _golden; }
+    /**
+     * @brief Input FASTA to take the reference k-mers from, empty if the
+     * golden output is used instead
+     */
+    const std::string &input() const { return _input; }
+    bool has_input() const { return !_input.empty(); }
+    const std::string &reference() const {
+        return has_input() ? _input : _golden;
+    }
 
   private:
-    CompareArgs(std::size_t k, bool unidirectional, std::string &&output,
-                std::string &&golden)
-        : _k(k), _unidirectional(unidirectional), _output(std::move(output)),
-          _golden(std::move(golden)) {}
+    CompareArgs(std::size_t k, std::size_t threads, bool unidirectional,
+                bool sort, double sample_rate, std::size_t memory,
+                std::string &&output, std::string &&golden,
+                std::string &&input)
+        : _k(k), _threads(threads), _unidirectional(unidirectional),
+          _sort(sort), _sample_rate(sample_rate), _memory(memory),
+          _output(std::move(output)), _golden(std::move(golden)),
+          _input(std::move(input)) {}
     std::size_t _k;
+    std::size_t _threads;
     bool _unidirectional;
+    bool _sort;
+    double _sample_rate;
+    std::size_t _memory;
     std::string _output;
     std::string _golden;
+    std::string _input;
 };
 
 #endif
@@ -1,25 +1,69 @@
 #ifndef BITSET_HPP
 #define BITSET_HPP
 
+#include "helper/page_memory.hpp"
+#include <cassert>
 #include <cstdint>
-#include <memory>
+#include <span>
 
+/**
+ * @brief Fixed-size bitset held in 64-bit words on the heap
+ *
+ * The accessors do not check the index, which has to be less than size(). The
+ * bits past size() in the last word are always zero, so the words can be
+ * merged, counted and serialized as a whole.
+ */
 class DynamicBitset {
-  private:
-    using inner_t = std::uint32_t;
-    static constexpr std::size_t inner_size = sizeof(inner_t) * 8;
-
   public:
+    using word_t = std::uint64_t;
+    static constexpr std::size_t word_size = sizeof(word_t) * 8;
+
     DynamicBitset() : _size(0) {}
     DynamicBitset(std::size_t size);
-    void set(std::size_t ind);
-    void reset(std::size_t ind);
-    bool test(std::size_t ind) const;
+    void set(std::size_t ind) {
+        assert(ind < _size);
+        data[ind / word_size] |= mask(ind);
+    }
+    void reset(std::size_t ind) {
+        assert(ind < _size);
+        data[ind / word_size] &= ~mask(ind);
+    }
+    bool test(std::size_t ind) const {
+        assert(ind < _size);
+        return data[ind / word_size] & mask(ind);
+    }
+    /**
+     * @brief Hint that a bit is about to be tested and possibly set
+     */
+    void prefetch(std::size_t ind) const {
+        __builtin_prefetch(data.get() + ind / word_size, 1);
+    }
     std::size_t size() const { return _size; }
+    /**
+     * @brief Number of set bits
+     */
+    std::size_t count() const;
+    /**
+     * @brief Union with a bitset of the same size
+     */
+    DynamicBitset &operator|=(const DynamicBitset &other);
+    /**
+     * @brief Intersection with a bitset of the same size
+     */
+    DynamicBitset &operator&=(const DynamicBitset &other);
+    std::span<word_t> words() { return {data.get(), word_count()}; }
+    std::span<const word_t> words() const { return {data.get(), word_count()}; }
 
   private:
+    static word_t mask(std::size_t ind) {
+        return word_t(1) << (ind % word_size);
+    }
+    std::size_t word_count() const {
+        return (_size + word_size - 1) / word_size;
+    }
+
     std::size_t _size;
-    std::unique_ptr<inner_t[]> data;
+    page_ptr<word_t> data;
 };
 
 #endif
@@ -1,21 +1,30 @@
 #ifndef COUNTING_BITSET_HPP
 #define COUNTING_BITSET_HPP
 
+#include "helper/page_memory.hpp"
 #include <algorithm>
-#include <memory>
+#include <cstdint>
+#include <type_traits>
 
+/**
+ * @brief Array of saturating counters of BPC bits each
+ *
+ * Counters of 4 and 8 bits are stored in bytes, so that the index arithmetic
+ * reduces to shifts and an update is a single read-modify-write of a nibble or
+ * a byte. Other sizes are packed into 32-bit words.
+ */
 template <std::size_t BPC>
 class CountingBitset {
   public:
-    using inner_t = std::uint32_t;
+    using inner_t = std::conditional_t<BPC == 4 || BPC == 8, std::uint8_t,
+                                       std::uint32_t>;
 
     CountingBitset() : _size(0) {}
     CountingBitset(std::size_t size) : _size(size) {
         std::size_t inner_size = (size + cells_per_inner - 1) / cells_per_inner;
-        data = std::make_unique<inner_t[]>(inner_size);
-        std::fill(data.get(), data.get() + inner_size, 0);
+        data = allocate_zeroed<inner_t>(inner_size);
     }
-    void set(std::size_t ind, inner_t count) {
+    void set(std::size_t ind, std::size_t count) {
         if (count > max_count) {
             count = max_count;
         }
@@ -23,7 +32,7 @@ class CountingBitset {
         std::size_t cell = get_index(ind);
         std::size_t offset = get_offset(ind);
 
-        data[cell] |= (count << offset);
+        data[cell] |= (inner_t)(count << offset);
     }
     void reset(std::size_t ind) {
         std::size_t cell = get_index(ind);
@@ -39,17 +48,37 @@ class CountingBitset {
     }
     bool test(std::size_t ind) const { return get(ind) > 0; }
     bool is_stuck(std::size_t ind) const { return get(ind) == max_count; }
+    /**
+     * @brief Increment a counter, saturating at the maximum
+     */
     void increment(std::size_t ind) {
-        if (get(ind) < max_count) {
-            set(ind, get(ind) + 1);
+        inner_t &word = data[get_index(ind)];
+        std::size_t offset = get_offset(ind);
+        if (((word >> offset) & cell_mask) != max_count) {
+            word += inner_t(1) << offset;
         }
     }
     void decrement(std::size_t ind) {
-        if (get(ind) > 0) {
-            set(ind, get(ind) - 1);
+        inner_t &word = data[get_index(ind)];
+        std::size_t offset = get_offset(ind);
+        if (((word >> offset) & cell_mask) != 0) {
+            word -= inner_t(1) << offset;
         }
     }
     std::size_t size() const { return _size; }
+    /**
+     * @brief Size of the counters in bytes
+     */
+    std::size_t memory() const {
+        return (_size + cells_per_inner - 1) / cells_per_inner *
+               sizeof(inner_t);
+    }
+    /**
+     * @brief Bits taken per counter, including the unused bits of a word
+     */
+    static constexpr double bits_per_counter() {
+        return (double)inner_size / cells_per_inner;
+    }
 
   private:
     static constexpr std::size_t inner_size = sizeof(inner_t) * 8;
@@ -64,7 +93,7 @@ class CountingBitset {
         return (ind % cells_per_inner) * BPC;
     }
     std::size_t _size;
-    std::unique_ptr<inner_t[]> data;
+    page_ptr<inner_t> data;
 };
 
 #endif
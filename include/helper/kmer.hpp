@@ -1,13 +1,57 @@
 #ifndef KMER_HPP
 #define KMER_HPP
 
+#include <algorithm>
+#include <array>
+#include <concepts>
 #include <cstdint>
 #include <string>
+#include <type_traits>
+#include <utility>
 
-enum Nucleotide { A = 0, C = 1, G = 2, T = 3, N = 4 };
+enum Nucleotide : std::uint8_t { A = 0, C = 1, G = 2, T = 3, N = 4 };
 constexpr Nucleotide COMPLEMENT[] = {T, G, C, A, N};
 
-Nucleotide char_to_nucleotide(char c);
+/**
+ * @brief Code of every byte value, INVALID_NUCLEOTIDE for non-nucleotides.
+ * N and the IUPAC ambiguity codes, in either case, are all mapped to N.
+ */
+constexpr std::uint8_t INVALID_NUCLEOTIDE = 0xff;
+constexpr std::array<std::uint8_t, 256> NUCLEOTIDE_CODES = [] {
+    std::array<std::uint8_t, 256> codes;
+    codes.fill(INVALID_NUCLEOTIDE);
+    codes['A'] = codes['a'] = A;
+    codes['C'] = codes['c'] = C;
+    codes['G'] = codes['g'] = G;
+    codes['T'] = codes['t'] = T;
+    for (char c : {'N', 'R', 'Y', 'S', 'W', 'K', 'M', 'B', 'D', 'H', 'V'}) {
+        codes[c] = codes[c - 'A' + 'a'] = N;
+    }
+    return codes;
+}();
+
+[[noreturn]] void throw_invalid_nucleotide();
+
+inline Nucleotide char_to_nucleotide(char c) {
+    auto code = NUCLEOTIDE_CODES[(std::uint8_t)c];
+    if (code == INVALID_NUCLEOTIDE) [[unlikely]] {
+        throw_invalid_nucleotide();
+    }
+    return (Nucleotide)code;
+}
+
+/**
+ * @brief Encode a run of unambiguous nucleotide characters at once
+ * @return The number of characters encoded, i.e. the position of the first
+ * character that is not one of A, C, G or T, or `n`
+ */
+std::size_t encode_nucleotides(const char *in, std::size_t n, Nucleotide *out);
+
+/**
+ * @brief Length of the run of ambiguous nucleotide characters (N or IUPAC
+ * codes) at the start of `in`
+ */
+std::size_t skip_ambiguous(const char *in, std::size_t n);
 
 enum class KmerRepr {
     FORWARD,
@@ -15,12 +59,52 @@ enum class KmerRepr {
     CANON,
 };
 
-class Kmer {
+/**
+ * @brief A k-mer with 2 bits per nucleotide, together with its reverse
+ * complement
+ *
+ * With a nonzero `FixedK`, the size is a compile-time constant, and so are the
+ * masks and shifts used on every roll. `Kmer` is the generic k-mer whose size
+ * is only known at runtime. `Data` is the integer type the k-mer is stored in,
+ * it limits the size to 4 bases per byte.
+ */
+template <std::size_t FixedK = 0, class Data = std::uint64_t>
+class BasicKmer {
   public:
-    using data_t = std::uint64_t;
-    explicit Kmer(std::size_t K) : K(K), _data(0), _rev_data(0), n_count(0) {}
-    explicit Kmer(const std::string &kmer);
-    void roll(char c);
+    using data_t = Data;
+    static constexpr std::size_t fixed_size = FixedK;
+    static constexpr std::size_t max_size = 4 * sizeof(Data);
+    static_assert(FixedK <= max_size);
+
+    explicit BasicKmer(std::size_t K = FixedK)
+        : K(FixedK ? FixedK : K), _data(0), _rev_data(0), n_count(0),
+          _mask(mask_for(K)) {}
+    explicit BasicKmer(const std::string &kmer)
+        requires(FixedK == 0)
+        : BasicKmer(kmer.size()) {
+        for (std::size_t i = 0; i < kmer.size(); i++) {
+            auto n = char_to_nucleotide(kmer[i]);
+            _data |= (data_t)n << (2 * (K - 1 - i));
+            _rev_data |= (data_t)COMPLEMENT[n] << (2 * i);
+        }
+        n_count = kmer.size();
+    }
+    /**
+     * @brief Convert a k-mer of a fixed size to the generic one
+     */
+    template <std::size_t K>
+        requires(FixedK == 0 && K != 0)
+    BasicKmer(const BasicKmer<K, Data> &other)
+        : K(K), _data(other.data(KmerRepr::FORWARD)),
+          _rev_data(other.data(KmerRepr::REVERSE)),
+          n_count(other.available()), _mask(mask_for(K)) {}
+    void roll(char c) { roll(char_to_nucleotide(c)); }
+    void roll(Nucleotide n) {
+        _data = ((_data << 2) | n) & mask();
+        _rev_data = (_rev_data >> 2) |
+                    ((data_t)COMPLEMENT[n] << (2 * (size() - 1)));
+        n_count++;
+    }
 
     /**
      * @brief Get the nucleotide at position i (0-indexed, from right to left)
@@ -30,28 +114,98 @@ class Kmer {
      * @return The nucleotide at position i
      */
     Nucleotide get(std::size_t i,
-                   KmerRepr representation = KmerRepr::FORWARD) const;
+                   KmerRepr representation = KmerRepr::FORWARD) const {
+        if (i >= size() || i >= n_count) {
+            return Nucleotide::N;
+        }
+        return static_cast<Nucleotide>((data(representation) >> (i * 2)) &
+                                       0b11);
+    }
     Nucleotide last(KmerRepr representation = KmerRepr::FORWARD) const {
-        return get(K - 1, representation);
+        return get(size() - 1, representation);
     }
-    std::size_t size() const { return K; }
-    std::size_t available() const { return std::min(K, n_count); }
+    std::size_t size() const { return FixedK ? FixedK : K; }
+    std::size_t available() const { return std::min(size(), n_count); }
     void reset() {
         _data = 0;
         _rev_data = 0;
         n_count = 0;
     }
-    bool operator==(const Kmer &other) const {
-        return other.K == K &&
+    bool operator==(const BasicKmer &other) const {
+        return other.size() == size() &&
                (_data == other._data || _data == other._rev_data);
     }
-    const data_t &data(KmerRepr representation) const;
-    bool use_reverse(KmerRepr representation) const;
+    const data_t &data(KmerRepr representation) const {
+        switch (representation) {
+        case KmerRepr::FORWARD:
+            return _data;
+        case KmerRepr::REVERSE:
+            return _rev_data;
+        case KmerRepr::CANON:
+            return _data < _rev_data ? _data : _rev_data;
+        }
+        std::unreachable();
+    }
+    bool use_reverse(KmerRepr representation) const {
+        switch (representation) {
+        case KmerRepr::FORWARD:
+            return false;
+        case KmerRepr::REVERSE:
+            return true;
+        case KmerRepr::CANON:
+            return _data > _rev_data;
+        }
+        std::unreachable();
+    }
 
   private:
+    static constexpr data_t mask_for(std::size_t K) {
+        return K >= max_size ? ~(data_t)0 : ((data_t)1 << (2 * K)) - 1;
+    }
+    data_t mask() const { return FixedK ? mask_for(FixedK) : _mask; }
     std::size_t K;
     data_t _data, _rev_data;
     std::size_t n_count;
+    data_t _mask;
 };
 
+using Kmer = BasicKmer<>;
+using WideKmer = BasicKmer<0, unsigned __int128>;
+
+constexpr std::size_t MAX_KMER_SIZE = WideKmer::max_size;
+
+template <class T>
+concept KmerType = requires {
+    typename T::data_t;
+    T::fixed_size;
+} && std::same_as<T, BasicKmer<T::fixed_size, typename T::data_t>>;
+
+/**
+ * @brief Call `f` with `std::type_identity` of the k-mer type the algorithms
+ * should use for k-mers of size `K`: a k-mer of fixed size if the algorithms
+ * are instantiated for it, otherwise the generic Kmer, or WideKmer for sizes
+ * above 32
+ */
+template <class F>
+decltype(auto) with_kmer_size(std::size_t K, F &&f) {
+    using std::type_identity;
+    switch (K) {
+    case 15:
+        return f(type_identity<BasicKmer<15>>());
+    case 21:
+        return f(type_identity<BasicKmer<21>>());
+    case 25:
+        return f(type_identity<BasicKmer<25>>());
+    case 31:
+        return f(type_identity<BasicKmer<31>>());
+    case 32:
+        return f(type_identity<BasicKmer<32>>());
+    default:
+        if (K > Kmer::max_size) {
+            return f(type_identity<WideKmer>());
+        }
+        return f(type_identity<Kmer>());
+    }
+}
+
 #endif
@@ -0,0 +1,59 @@
+#ifndef KMER_CACHE_HPP
+#define KMER_CACHE_HPP
+
+#include "helper/kmer.hpp"
+#include <bit>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @brief Direct-mapped cache of recently seen k-mers
+ *
+ * Every k-mer representation maps to one slot, which keeps the last k-mer
+ * stored there. A hit is exact, so a k-mer found in the cache has been seen
+ * before, while a miss says nothing. The cache takes 16 KB to stay in the L1
+ * cache, enough for the repeats within a tandem repeat or a low-complexity
+ * region.
+ * @tparam Key The k-mer representation, Kmer::data_t or WideKmer::data_t
+ */
+template <class Key = Kmer::data_t>
+class KmerCache {
+    static constexpr std::size_t bytes = 16 * 1024;
+    static constexpr std::size_t slots = bytes / sizeof(Key);
+    static constexpr std::size_t slot_bits = std::countr_zero(slots);
+    // Not a canonical k-mer nor a forward k-mer of fewer than 32 bases
+    static constexpr Key EMPTY = ~(Key)0;
+
+  public:
+    KmerCache() : keys(slots, EMPTY) {}
+    /**
+     * @brief Whether `key` is cached, storing it in its slot in any case
+     */
+    bool test_and_set(Key key) {
+        auto &slot = keys[index(key)];
+        bool hit = slot == key && key != EMPTY;
+        slot = key;
+        lookups++;
+        _hits += hit;
+        return hit;
+    }
+    double hit_rate() const {
+        return lookups ? (double)_hits / lookups : 0;
+    }
+
+  private:
+    static std::size_t index(Key key) {
+        std::uint64_t x = key;
+        if constexpr (sizeof(Key) > sizeof(x)) {
+            x ^= key >> 64;
+        }
+        // Fibonacci hashing, the top bits of the product depend on all bits
+        return (x * 0x9e3779b97f4a7c15ULL) >> (64 - slot_bits);
+    }
+
+    std::vector<Key> keys;
+    std::size_t lookups = 0;
+    std::size_t _hits = 0;
+};
+
+#endif
@@ -0,0 +1,315 @@
+#ifndef KMER_SET_HPP
+#define KMER_SET_HPP
+
+#include "helper/kmer.hpp"
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <memory>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+/**
+ * @brief Open-addressing hash set of integer k-mer representations.
+ *
+ * Slots are organized into groups of 16 with one control byte per slot, as in
+ * Swiss tables. A control byte holds 7 bits of the hash of a full slot, or one
+ * of the EMPTY and DELETED markers. All control bytes of a group are compared
+ * at once (with SSE2 when available) and keys are only compared on a tag match.
+ * Groups are probed linearly. The number of groups does not have to be a power
+ * of two, so the table can be sized close to the expected number of k-mers.
+ * @tparam Key The k-mer representation, Kmer::data_t or WideKmer::data_t
+ */
+template <class Key = Kmer::data_t>
+class BasicKmerSet {
+  public:
+    using key_t = Key;
+
+  private:
+    using ctrl_t = std::int8_t;
+    static constexpr ctrl_t EMPTY = -128;
+    static constexpr ctrl_t DELETED = -2;
+    static constexpr std::size_t group_size = 16;
+    static constexpr std::size_t max_load_num = 7;
+    static constexpr std::size_t max_load_den = 8;
+
+    class Group {
+      public:
+        explicit Group(const ctrl_t *ctrl) {
+#ifdef __SSE2__
+            data = _mm_loadu_si128(reinterpret_cast<const __m128i *>(ctrl));
+#else
+            std::copy(ctrl, ctrl + group_size, data);
+#endif
+        }
+        std::uint32_t match(ctrl_t tag) const {
+#ifdef __SSE2__
+            return _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_set1_epi8(tag), data));
+#else
+            std::uint32_t mask = 0;
+            for (std::size_t i = 0; i < group_size; i++) {
+                mask |= (std::uint32_t)(data[i] == tag) << i;
+            }
+            return mask;
+#endif
+        }
+        std::uint32_t match_empty() const { return match(EMPTY); }
+        std::uint32_t match_empty_or_deleted() const {
+#ifdef __SSE2__
+            return _mm_movemask_epi8(data);
+#else
+            std::uint32_t mask = 0;
+            for (std::size_t i = 0; i < group_size; i++) {
+                mask |= (std::uint32_t)(data[i] < 0) << i;
+            }
+            return mask;
+#endif
+        }
+
+      private:
+#ifdef __SSE2__
+        __m128i data;
+#else
+        ctrl_t data[group_size];
+#endif
+    };
+
+  public:
+    BasicKmerSet() : BasicKmerSet(0) {}
+    explicit BasicKmerSet(std::size_t capacity) {
+        allocate(groups_for(capacity));
+    }
+
+    /**
+     * @brief Make room for at least `capacity` elements without rehashing
+     */
+    void reserve(std::size_t capacity) {
+        std::size_t groups = groups_for(capacity);
+        if (groups > ngroups) {
+            rehash(groups);
+        }
+    }
+    /**
+     * @brief Insert a key into the set
+     * @return True if the key was not present before
+     */
+    bool insert(key_t key) {
+        auto hash = mix(key);
+        auto tag = get_tag(hash);
+        std::size_t g = get_group(hash);
+        std::size_t target = npos;
+        while (true) {
+            Group group(ctrl.get() + g * group_size);
+            for (auto m = group.match(tag); m; m &= m - 1) {
+                std::size_t slot = g * group_size + std::countr_zero(m);
+                if (slots[slot] == key) {
+                    return false;
+                }
+            }
+            auto available = group.match_empty_or_deleted();
+            if (target == npos && available) {
+                target = g * group_size + std::countr_zero(available);
+            }
+            if (group.match_empty()) {
+                break;
+            }
+            g = next_group(g);
+        }
+        if (ctrl[target] == EMPTY && used + 1 > max_used()) {
+            rehash(size() + 1 > max_used() ? 2 * ngroups : ngroups);
+            insert_unique(key);
+            _size++;
+            return true;
+        }
+        used += ctrl[target] == EMPTY;
+        ctrl[target] = tag;
+        slots[target] = key;
+        _size++;
+        return true;
+    }
+    bool contains(key_t key) const { return find(key) != npos; }
+    /**
+     * @brief Remove a key from the set
+     * @return True if the key was present
+     */
+    bool erase(key_t key) {
+        std::size_t slot = find(key);
+        if (slot == npos) {
+            return false;
+        }
+        ctrl[slot] = DELETED;
+        _size--;
+        return true;
+    }
+    void clear() {
+        std::fill(ctrl.get(), ctrl.get() + capacity(), EMPTY);
+        _size = 0;
+        used = 0;
+    }
+    std::size_t size() const { return _size; }
+    std::size_t capacity() const { return ngroups * group_size; }
+    /**
+     * @brief Size of the table in bytes
+     */
+    std::size_t memory() const {
+        return capacity() * (sizeof(key_t) + sizeof(ctrl_t));
+    }
+    /**
+     * @brief Size in bytes of a table reserved for `capacity` elements
+     */
+    static std::size_t memory_for(std::size_t capacity) {
+        return groups_for(capacity) * group_size *
+               (sizeof(key_t) + sizeof(ctrl_t));
+    }
+
+  private:
+    static constexpr std::size_t npos = -1;
+
+    /**
+     * @brief The MurMur3 64-bit finalizer, the k-mer representation itself is
+     * far from uniform. Wide keys are folded to 64 bits first.
+     */
+    static std::uint64_t mix(key_t wide) {
+        std::uint64_t key = wide;
+        if constexpr (sizeof(key_t) > sizeof(std::uint64_t)) {
+            key ^= (std::uint64_t)(wide >> 64) * 0x9e3779b97f4a7c15ULL;
+        }
+        key ^= key >> 33;
+        key *= 0xff51afd7ed558ccdULL;
+        key ^= key >> 33;
+        key *= 0xc4ceb9fe1a85ec53ULL;
+        key ^= key >> 33;
+        return key;
+    }
+    static ctrl_t get_tag(std::uint64_t hash) { return hash & 0x7f; }
+    std::size_t get_group(std::uint64_t hash) const {
+        return ((unsigned __int128)hash * ngroups) >> 64;
+    }
+    std::size_t next_group(std::size_t g) const {
+        return g + 1 == ngroups ? 0 : g + 1;
+    }
+    std::size_t max_used() const {
+        return capacity() * max_load_num / max_load_den;
+    }
+    static std::size_t groups_for(std::size_t capacity) {
+        std::size_t slots = (capacity * max_load_den + max_load_num - 1) /
+                            max_load_num;
+        return std::max<std::size_t>(1, (slots + group_size - 1) / group_size);
+    }
+    std::size_t find(key_t key) const {
+        auto hash = mix(key);
+        auto tag = get_tag(hash);
+        std::size_t g = get_group(hash);
+        while (true) {
+            Group group(ctrl.get() + g * group_size);
+            for (auto m = group.match(tag); m; m &= m - 1) {
+                std::size_t slot = g * group_size + std::countr_zero(m);
+                if (slots[slot] == key) {
+                    return slot;
+                }
+            }
+            if (group.match_empty()) {
+                return npos;
+            }
+            g = next_group(g);
+        }
+    }
+    /**
+     * @brief Insert a key known not to be in the set, without tombstones
+     */
+    void insert_unique(key_t key) {
+        auto hash = mix(key);
+        std::size_t g = get_group(hash);
+        while (true) {
+            Group group(ctrl.get() + g * group_size);
+            if (auto m = group.match_empty()) {
+                std::size_t slot = g * group_size + std::countr_zero(m);
+                ctrl[slot] = get_tag(hash);
+                slots[slot] = key;
+                used++;
+                return;
+            }
+            g = next_group(g);
+        }
+    }
+    void allocate(std::size_t groups) {
+        ngroups = groups;
+        ctrl = std::make_unique<ctrl_t[]>(capacity());
+        slots = std::make_unique_for_overwrite<key_t[]>(capacity());
+        std::fill(ctrl.get(), ctrl.get() + capacity(), EMPTY);
+        used = 0;
+    }
+    void rehash(std::size_t groups) {
+        auto old_ctrl = std::move(ctrl);
+        auto old_slots = std::move(slots);
+        std::size_t old_capacity = capacity();
+        allocate(groups);
+        for (std::size_t i = 0; i < old_capacity; i++) {
+            if (old_ctrl[i] >= 0) {
+                insert_unique(old_slots[i]);
+            }
+        }
+    }
+
+    std::unique_ptr<ctrl_t[]> ctrl;
+    std::unique_ptr<key_t[]> slots;
+    std::size_t ngroups;
+    std::size_t _size = 0;
+    std::size_t used = 0;
+};
+
+using KmerSet = BasicKmerSet<>;
+
+/**
+ * @brief Exact set of k-mers with the rolling interface of the filters of the
+ * streaming algorithm, for when the k-mers to store are known to be few
+ * @tparam KmerT The k-mer type, of a fixed size if known at compile time
+ */
+template <KmerType KmerT = Kmer>
+class RollingKmerSet {
+    using Self = RollingKmerSet;
+    using Set = BasicKmerSet<typename KmerT::data_t>;
+
+  public:
+    /**
+     * @brief Set reserved for `num_elements` k-mers, regardless of `bits`
+     */
+    static Self for_memory(std::size_t num_elements, std::size_t,
+                           std::size_t k, KmerRepr repr) {
+        return Self(num_elements, k, repr);
+    }
+    /**
+     * @brief Size in bytes of a set reserved for `num_elements` k-mers
+     */
+    static std::size_t memory_for(std::size_t num_elements) {
+        return Set::memory_for(num_elements);
+    }
+    static const char *name() { return "Exact K-mer Set"; }
+    /**
+     * @brief The set has no false positives
+     */
+    static constexpr bool exact = true;
+
+    RollingKmerSet(std::size_t capacity, std::size_t k, KmerRepr repr)
+        : set(capacity), kmer(KmerT::fixed_size ? KmerT::fixed_size : k),
+          repr(repr) {}
+    void reset_hash_family() { kmer.reset(); }
+    void roll(Nucleotide n) { kmer.roll(n); }
+    void insert_this() { set.insert(kmer.data(repr)); }
+    void erase_this() { set.erase(kmer.data(repr)); }
+    bool contains_this() const { return set.contains(kmer.data(repr)); }
+    std::size_t hashes() const { return 1; }
+    std::size_t size() const { return set.size(); }
+    std::size_t memory() const { return set.memory(); }
+    double error_rate(std::size_t) const { return 0; }
+    std::size_t overflows() const { return 0; }
+
+  private:
+    Set set;
+    KmerT kmer;
+    KmerRepr repr;
+};
+
+#endif
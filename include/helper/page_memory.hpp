@@ -0,0 +1,91 @@
+#ifndef PAGE_MEMORY_HPP
+#define PAGE_MEMORY_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <ostream>
+#include <type_traits>
+
+/**
+ * @brief How large zeroed arrays are backed by huge pages
+ */
+enum class HugePages {
+    // Regular pages only
+    NONE,
+    // Ask for transparent huge pages with madvise
+    TRANSPARENT,
+    // Take the pages from the hugetlbfs pool, falling back to TRANSPARENT
+    EXPLICIT,
+};
+
+/**
+ * @brief Set the huge page policy of all following allocate_zeroed calls
+ */
+void set_huge_pages(HugePages policy);
+
+struct PageDeleter {
+    std::size_t bytes = 0;
+    void operator()(void *data) const;
+};
+
+template <class T>
+using page_ptr = std::unique_ptr<T[], PageDeleter>;
+
+/**
+ * @brief Map `bytes` of zeroed memory, null if `bytes` is zero
+ * @param bytes Rounded up to the size actually mapped
+ */
+void *allocate_zeroed_pages(std::size_t &bytes);
+
+/**
+ * @brief Allocate an array of `count` zeroed elements directly from the
+ * operating system
+ *
+ * Anonymous mappings are zeroed by the kernel and faulted in lazily, so unlike
+ * std::make_unique followed by std::fill, no page is touched until it is used.
+ * Large arrays are backed by huge pages according to set_huge_pages, which
+ * lowers the TLB misses of random accesses.
+ */
+template <class T>
+    requires std::is_trivial_v<T>
+page_ptr<T> allocate_zeroed(std::size_t count) {
+    std::size_t bytes = count * sizeof(T);
+    void *data = allocate_zeroed_pages(bytes);
+    return page_ptr<T>(static_cast<T *>(data), PageDeleter{bytes});
+}
+
+/**
+ * @brief Page faults, huge page usage and TLB misses of the process so far
+ */
+struct MemoryStats {
+    std::size_t minor_faults = 0;
+    std::size_t major_faults = 0;
+    // Anonymous memory currently backed by transparent huge pages
+    std::size_t huge_page_bytes = 0;
+    // Data TLB read misses since the TlbCounter was created, if the
+    // performance counters are available
+    std::optional<std::uint64_t> tlb_misses;
+};
+
+/**
+ * @brief Counter of data TLB read misses of the calling thread
+ */
+class TlbCounter {
+  public:
+    TlbCounter();
+    TlbCounter(const TlbCounter &) = delete;
+    TlbCounter &operator=(const TlbCounter &) = delete;
+    ~TlbCounter();
+    std::optional<std::uint64_t> read() const;
+
+  private:
+    int fd = -1;
+};
+
+MemoryStats memory_stats(const TlbCounter *tlb = nullptr);
+
+std::ostream &operator<<(std::ostream &os, const MemoryStats &stats);
+
+#endif
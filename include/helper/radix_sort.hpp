@@ -0,0 +1,20 @@
+#ifndef RADIX_SORT_HPP
+#define RADIX_SORT_HPP
+
+#include <cstdint>
+#include <span>
+
+/**
+ * @brief Sort integer keys using at most `key_bits` lowest bits
+ *
+ * The keys are first partitioned in place by their 8 highest bits, then the
+ * partitions are sorted in parallel by a least significant digit radix sort.
+ * Apart from the input, only a buffer of the size of a partition per thread is
+ * allocated.
+ */
+void radix_sort(std::span<std::uint64_t> data, std::size_t key_bits,
+                std::size_t threads = 1);
+void radix_sort(std::span<unsigned __int128> data, std::size_t key_bits,
+                std::size_t threads = 1);
+
+#endif
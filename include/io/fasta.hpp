@@ -3,7 +3,10 @@
 
 #include "helper/kmer.hpp"
 #include "io/streams.hpp"
+#include <cctype>
 #include <string>
+#include <string_view>
+#include <vector>
 
 namespace io {
 
@@ -11,11 +14,14 @@ class FastaReader {
   private:
     static constexpr char CommentChar = '>';
     static constexpr std::size_t MaxHeaderSize = 80;
+    static constexpr std::size_t MaxChunkSize = 1 << 16;
 
   public:
     FastaReader(input_stream &&stream) : stream(std::move(stream)) {}
     FastaReader(const std::string &path) : stream(path) {}
     bool next_sequence() {
+        chunk.clear();
+        position = 0;
         if (stream.eof() || stream.peek() != CommentChar)
             return false;
         stream.ignore();
@@ -28,10 +34,26 @@ class FastaReader {
         }
         return stream.get(next);
     }
+    /**
+     * @brief Read the next run of the current sequence and encode all of its
+     * nucleotides at once. A run holds either only unambiguous nucleotides or
+     * only ambiguous ones (N and IUPAC codes), see ambiguous().
+     * @param run The characters of the run, valid until the next call
+     * @param bases The encoded nucleotides of the run
+     * @return False at the end of the sequence
+     */
+    bool next_bases(std::string_view &run, std::vector<Nucleotide> &bases);
+    /**
+     * @brief Whether the last run read by next_bases is ambiguous, such runs
+     * break the sequence into independent parts
+     */
+    bool ambiguous() const { return _ambiguous; }
     const std::string &get_header() const { return header; }
     void reset() {
         stream.reset();
         header.clear();
+        chunk.clear();
+        position = 0;
     }
 
   private:
@@ -41,33 +63,120 @@ class FastaReader {
             stream.ignore();
         }
     }
+    bool next_chunk();
     input_stream stream;
     std::string header;
+    // Part of a line of the current sequence read by next_bases
+    std::string chunk;
+    std::size_t position = 0;
+    bool _ambiguous = false;
 };
 
+/**
+ * @brief Consumer of the runs of a FASTA file, see read_runs
+ */
+class RunConsumer {
+  public:
+    virtual ~RunConsumer() = default;
+    virtual void next_sequence() = 0;
+    /**
+     * @brief A run of unambiguous bases, see FastaReader::next_bases
+     */
+    virtual void bases(std::string_view run,
+                       const std::vector<Nucleotide> &bases) = 0;
+    /**
+     * @brief A run of ambiguous bases, which no k-mer spans
+     */
+    virtual void ambiguous(std::string_view run) = 0;
+    virtual void end_sequence() = 0;
+};
+
+/**
+ * @brief Read all sequences of a FASTA file, passing every run to all the
+ * consumers in order. The input is read, parsed and encoded only once no
+ * matter the number of consumers.
+ */
+void read_runs(FastaReader &in, const std::vector<RunConsumer *> &consumers);
+
 enum {
     NOT_PRESENT = 0,
     PRESENT = 1,
 };
 
-class KmerWriter {
+/**
+ * @brief Writer of a masked superstring, one base at a time, keeping the
+ * pending bases in a `KmerT`
+ */
+template <KmerType KmerT = Kmer>
+class BasicKmerWriter {
+    static constexpr char nucleotide_to_char[] = {'a', 'c', 'g', 't', 'X'};
+
   public:
-    KmerWriter(output_stream &&stream, std::size_t K, bool splice)
+    BasicKmerWriter(output_stream &&stream, std::size_t K, bool splice)
         : stream(std::move(stream)), kmer(K), last_one(K), splice(splice) {}
-    KmerWriter(const std::string &path, std::size_t K, bool splice)
+    BasicKmerWriter(const std::string &path, std::size_t K, bool splice)
         : stream(path), kmer(K), last_one(K), splice(splice) {}
-    void write_header(const std::string &header);
+    void write_header(const std::string &header) {
+        stream.write('>');
+        stream.write(header);
+        stream.write('\n');
+    }
     void add_nucleotide(char c) { kmer.roll(c); }
-    void print_nucleotide(int present);
-    void flush();
+    void add_nucleotide(Nucleotide n) { kmer.roll(n); }
+    void print_nucleotide(int present) {
+        auto n = kmer.last();
+        auto to_print = nucleotide_to_char[n];
+        if (present == PRESENT) {
+            last_one = 0;
+            to_print = std::toupper(to_print);
+        }
+        if (!splice || last_one < kmer.size()) {
+            stream.write(to_print);
+            lowercase_written += present != PRESENT;
+        }
+        last_one++;
+    }
+    /**
+     * @brief Print a run of ambiguous bases, which start no k-mer. The writer
+     * has to be flushed before.
+     */
+    void print_ambiguous(std::string_view run) {
+        for (char c : run) {
+            if (!splice || last_one < kmer.size()) {
+                stream.write((char)std::tolower(c));
+            }
+            last_one++;
+        }
+    }
+    void flush() {
+        // A sequence shorter than k has fewer bases pending than k - 1
+        int to_print = std::min(kmer.available(), kmer.size() - 1);
+        for (int i = to_print - 1; i >= 0; i--) {
+            auto to_write = nucleotide_to_char[kmer.get(i)];
+            if (!splice || last_one < kmer.size()) {
+                stream.write(to_write);
+                lowercase_written++;
+            }
+            last_one++;
+        }
+        kmer.reset();
+    }
+    /**
+     * @brief Number of lowercase unambiguous bases written so far, which
+     * bounds the number of k-mers starting at a lowercase base
+     */
+    std::size_t lowercase() const { return lowercase_written; }
 
   private:
     output_stream stream;
-    Kmer kmer;
+    KmerT kmer;
     std::size_t last_one;
     bool splice;
+    std::size_t lowercase_written = 0;
 };
 
+using KmerWriter = BasicKmerWriter<>;
+
 } // namespace io
 
 #endif
@@ -0,0 +1,134 @@
+#ifndef MAPPED_FASTA_HPP
+#define MAPPED_FASTA_HPP
+
+#include "helper/kmer.hpp"
+#include "io/mapped_file.hpp"
+#include <algorithm>
+#include <cctype>
+#include <string>
+#include <vector>
+
+namespace io {
+
+/**
+ * @brief The byte range of the sequence data of a record of a FASTA file
+ */
+struct Segment {
+    std::size_t begin, end;
+};
+
+/**
+ * @brief Find the byte ranges of sequence data of all records
+ */
+std::vector<Segment> find_segments(const MappedFile &file);
+
+/**
+ * @brief Pass the bases of the records in the byte range [lo, hi) of a FASTA
+ * file to `visitor`, so that byte ranges covering the file can be processed
+ * independently
+ *
+ * The part of every record in the range starts with `visitor.start(first)`,
+ * where `first` tells whether the record itself starts in the range. It is
+ * preceded by up to `context` bases of the same record before `lo`, so that
+ * k-mers ending in the range can be completed with a context of k - 1 bases.
+ * Every base is then passed to `visitor.base(n, c, in_range)` and every run of
+ * ambiguous bases to `visitor.ambiguous(count, in_range)`, where `in_range`
+ * is false for the context.
+ */
+template <class V>
+void visit_range(const MappedFile &file, const std::vector<Segment> &segments,
+                 std::size_t lo, std::size_t hi, std::size_t context,
+                 V &&visitor) {
+    // Encode runs of bases at once, stopping only at whitespace and at
+    // ambiguous bases, which no k-mer spans
+    constexpr std::size_t ENCODE_CHUNK = 4096;
+    const char *data = file.data();
+    std::string preceding;
+    Nucleotide bases[ENCODE_CHUNK];
+    for (auto &&segment : segments) {
+        std::size_t begin = std::max(segment.begin, lo);
+        std::size_t end = std::min(segment.end, hi);
+        // A record without bases belongs to the range of its start, the
+        // last range if it ends the file
+        if (segment.begin == segment.end && segment.begin >= lo &&
+            (segment.begin < hi || hi == file.size())) {
+            visitor.start(true);
+            continue;
+        }
+        if (begin >= end) {
+            continue;
+        }
+        visitor.start(begin == segment.begin);
+        // Bases preceding the range in the same record, latest first
+        preceding.clear();
+        for (std::size_t i = begin;
+             i > segment.begin && preceding.size() < context; i--) {
+            if (!std::isspace(data[i - 1])) {
+                preceding.push_back(data[i - 1]);
+            }
+        }
+        for (auto it = preceding.rbegin(); it != preceding.rend(); it++) {
+            auto n = char_to_nucleotide(*it);
+            if (n == N) {
+                visitor.ambiguous(1, false);
+            } else {
+                visitor.base(n, *it, false);
+            }
+        }
+        for (std::size_t i = begin; i < end;) {
+            std::size_t n = std::min(end - i, ENCODE_CHUNK);
+            std::size_t encoded = encode_nucleotides(data + i, n, bases);
+            for (std::size_t j = 0; j < encoded; j++) {
+                visitor.base(bases[j], data[i + j], true);
+            }
+            i += encoded;
+            if (encoded == n) {
+                continue;
+            }
+            if (auto ambiguous = skip_ambiguous(data + i, end - i)) {
+                visitor.ambiguous(ambiguous, true);
+                i += ambiguous;
+            } else if (std::isspace(data[i])) {
+                i++;
+            } else {
+                throw_invalid_nucleotide();
+            }
+        }
+    }
+}
+
+/**
+ * @brief Consumer of the runs of a byte range of a FASTA file, see read_ranges
+ */
+class RangeConsumer {
+  public:
+    virtual ~RangeConsumer() = default;
+    /**
+     * @brief The part of a record in the range, `first` if the record itself
+     * starts in it
+     */
+    virtual void start(bool first) = 0;
+    /**
+     * @brief A run of unambiguous bases, of the context preceding the range
+     * if not `in_range`
+     */
+    virtual void bases(const std::vector<Nucleotide> &bases,
+                       bool in_range) = 0;
+    /**
+     * @brief A run of ambiguous bases, which no k-mer spans
+     */
+    virtual void ambiguous(std::size_t count, bool in_range) = 0;
+};
+
+/**
+ * @brief Split a FASTA file into one byte range per list of consumers and
+ * pass the runs of every range, with up to `context` bases preceding it, to
+ * its consumers in a thread of its own, see visit_range. Every range is
+ * parsed and encoded only once no matter the number of consumers.
+ */
+void read_ranges(const MappedFile &file, std::size_t context,
+                 const std::vector<std::vector<RangeConsumer *>> &consumers);
+
+} // namespace io
+
+#endif
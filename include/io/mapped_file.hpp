@@ -0,0 +1,29 @@
+#ifndef MAPPED_FILE_HPP
+#define MAPPED_FILE_HPP
+
+#include <string>
+
+namespace io {
+
+/**
+ * @brief Read-only memory mapping of a whole file
+ */
+class MappedFile {
+  public:
+    MappedFile(const std::string &path);
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+    ~MappedFile();
+    const char *data() const { return _data; }
+    std::size_t size() const { return _size; }
+    bool is_open() const { return _open; }
+
+  private:
+    const char *_data = nullptr;
+    std::size_t _size = 0;
+    bool _open = false;
+};
+
+} // namespace io
+
+#endif
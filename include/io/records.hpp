@@ -0,0 +1,103 @@
+#ifndef RECORDS_HPP
+#define RECORDS_HPP
+
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace io {
+
+/**
+ * @brief Buffered writer of fixed-size binary records
+ *
+ * Failing to open or write the file throws std::runtime_error. The destructor
+ * writes the remaining records without reporting errors, so call flush()
+ * before it to detect them.
+ */
+template <class T>
+    requires std::is_trivially_copyable_v<T>
+class RecordWriter {
+  public:
+    RecordWriter(const std::string &path, std::size_t buffer_size = 4096)
+        : path(path), stream(path, std::ios::binary) {
+        if (!stream.is_open()) {
+            throw std::runtime_error("Cannot open " + path);
+        }
+        buffer.reserve(buffer_size);
+    }
+    RecordWriter(RecordWriter &&) = default;
+    ~RecordWriter() { write_buffer(); }
+    void push(const T &record) {
+        buffer.push_back(record);
+        if (buffer.size() == buffer.capacity()) {
+            flush();
+        }
+    }
+    void flush() {
+        if (!write_buffer() || !stream.flush()) {
+            throw std::runtime_error("Cannot write " + path);
+        }
+    }
+    bool is_open() const { return stream.is_open(); }
+
+  private:
+    bool write_buffer() {
+        stream.write(reinterpret_cast<const char *>(buffer.data()),
+                     buffer.size() * sizeof(T));
+        buffer.clear();
+        return static_cast<bool>(stream);
+    }
+
+    std::string path;
+    std::ofstream stream;
+    std::vector<T> buffer;
+};
+
+/**
+ * @brief Buffered reader of fixed-size binary records
+ *
+ * Failing to open or read the file throws std::runtime_error.
+ */
+template <class T>
+    requires std::is_trivially_copyable_v<T>
+class RecordReader {
+  public:
+    RecordReader(const std::string &path, std::size_t buffer_size = 4096)
+        : path(path), stream(path, std::ios::binary), buffer(buffer_size) {
+        if (!stream.is_open()) {
+            throw std::runtime_error("Cannot open " + path);
+        }
+    }
+    RecordReader(RecordReader &&) = default;
+    bool next(T &record) {
+        if (position == available && !refill()) {
+            return false;
+        }
+        record = buffer[position++];
+        return true;
+    }
+    bool is_open() const { return stream.is_open(); }
+
+  private:
+    bool refill() {
+        stream.read(reinterpret_cast<char *>(buffer.data()),
+                    buffer.size() * sizeof(T));
+        if (stream.bad()) {
+            throw std::runtime_error("Cannot read " + path);
+        }
+        available = stream.gcount() / sizeof(T);
+        position = 0;
+        return available > 0;
+    }
+    std::string path;
+    std::ifstream stream;
+    std::vector<T> buffer;
+    std::size_t position = 0;
+    std::size_t available = 0;
+};
+
+} // namespace io
+
+#endif
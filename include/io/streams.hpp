@@ -15,6 +15,7 @@ class input_stream {
     bool eof() const;
     bool getline(std::string &);
     bool get(char &);
+    std::size_t get_line_part(char *buffer, std::size_t size);
     void ignore();
     void reset();
 
@@ -4,8 +4,20 @@
 #include "hash/hash_family.hpp"
 #include "helper/bitset.hpp"
 #include "math/modular.hpp"
+#include <algorithm>
 #include <cmath>
 
+/**
+ * @brief Number of hashes minimizing the error rate of a Bloom filter of `size`
+ * cells holding `num_elements` elements, at least one
+ */
+inline std::size_t optimal_hashes(std::size_t num_elements, std::size_t size) {
+    double bits_per_element =
+            (double)size / std::max<std::size_t>(num_elements, 1);
+    return std::max<std::size_t>(
+            1, std::round(std::log(2) * bits_per_element));
+}
+
 template <HashFamily H>
 class BloomFilter {
   public:
@@ -36,6 +48,11 @@ class BloomFilter {
                 1 - std::exp(-(double)k * num_elements / _size.get_mod()), k);
         return p;
     }
+    /**
+     * @brief Fraction of set bits, the error rate is about its power to the
+     * number of hashes
+     */
+    double fill_ratio() const { return (double)data.count() / size(); }
 
   private:
     DynamicBitset data;
@@ -53,12 +70,25 @@ class RollingBloomFilter {
         std::size_t nhashes = std::round(std::log(2) * bits_per_element);
         return RollingBloomFilter<H>(size, nhashes, k, repr);
     }
+    /**
+     * @brief Filter of `size` bits with the number of hashes minimizing the
+     * error rate for `num_elements` elements
+     */
+    static RollingBloomFilter<H> for_size(std::size_t num_elements,
+                                          std::size_t size, std::size_t k,
+                                          KmerRepr repr) {
+        return RollingBloomFilter<H>(size, optimal_hashes(num_elements, size),
+                                     k, repr);
+    }
+    static const char *name() { return "Bloom Filter"; }
+    std::size_t hashes() const { return hash_family.size(); }
     RollingBloomFilter(std::size_t size, std::size_t nhashes, std::size_t k,
                        KmerRepr repr)
         : _size(size), hash_family(nhashes, k, repr), data(size) {}
     void init(const Kmer &key) { hash_family.init(key); }
     void reset_hash_family() { hash_family.reset(); }
     void roll(char c) { hash_family.roll(c); }
+    void roll(Nucleotide n) { hash_family.roll(n); }
     void insert_this() {
         for (auto &&h : hash_family.get_hashes()) {
             data.set(_size.reduce(h));
@@ -71,6 +101,34 @@ class RollingBloomFilter {
         }
         return contains;
     }
+    /**
+     * @brief Number of positions of the probe of a k-mer
+     */
+    std::size_t probe_size() const { return hash_family.size(); }
+    /**
+     * @brief Write the bit positions of the current k-mer to `probe` and
+     * prefetch them, so that the k-mer can be tested and inserted a few k-mers
+     * later by contains_probe and insert_probe
+     */
+    void prefetch_this(std::size_t *probe) const {
+        auto hashes = hash_family.get_hashes();
+        for (std::size_t i = 0; i < hashes.size(); i++) {
+            probe[i] = _size.reduce(hashes[i]);
+            data.prefetch(probe[i]);
+        }
+    }
+    bool contains_probe(const std::size_t *probe) const {
+        bool contains = true;
+        for (std::size_t i = 0; i < probe_size(); i++) {
+            contains &= data.test(probe[i]);
+        }
+        return contains;
+    }
+    void insert_probe(const std::size_t *probe) {
+        for (std::size_t i = 0; i < probe_size(); i++) {
+            data.set(probe[i]);
+        }
+    }
     bool contains(const Kmer &kmer) const {
         H tmp_hash_family(hash_family);
         bool contains = true;
@@ -86,6 +144,11 @@ class RollingBloomFilter {
                 1 - std::exp(-(double)k * num_elements / _size.get_mod()), k);
         return p;
     }
+    /**
+     * @brief Fraction of set bits, the error rate is about its power to the
+     * number of hashes
+     */
+    double fill_ratio() const { return (double)data.count() / size(); }
 
   private:
     DynamicBitset data;
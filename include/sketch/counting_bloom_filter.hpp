@@ -2,9 +2,60 @@
 #define COUNTING_BLOOM_FILTER_HPP
 
 #include "hash/hash_family.hpp"
+#include "sketch/bloom_filter.hpp"
 #include "helper/counting_bitset.hpp"
 #include "math/modular.hpp"
+#include <algorithm>
 #include <cmath>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @brief Counters of a counting Bloom filter, saturated counters continue in
+ * an overflow table
+ *
+ * A counter at the maximum of BPC bits keeps the rest of its count in a hash
+ * map, so that it can be decremented exactly instead of staying stuck. At the
+ * usual 0.7 elements per counter, saturation is rare at 3 bits and more so at
+ * 4 bits.
+ */
+template <std::size_t BPC>
+class OverflowCounters {
+  public:
+    explicit OverflowCounters(std::size_t size) : data(size) {}
+    bool test(std::size_t ind) const { return data.test(ind); }
+    void increment(std::size_t ind) {
+        if (data.is_stuck(ind)) {
+            overflow[ind]++;
+        } else {
+            data.increment(ind);
+        }
+    }
+    void decrement(std::size_t ind) {
+        if (!overflow.empty() && data.is_stuck(ind)) {
+            auto it = overflow.find(ind);
+            if (it != overflow.end()) {
+                if (--it->second == 0) {
+                    overflow.erase(it);
+                }
+                return;
+            }
+        }
+        data.decrement(ind);
+    }
+    /**
+     * @brief Number of saturated counters with a count in the overflow table
+     */
+    std::size_t overflows() const { return overflow.size(); }
+    /**
+     * @brief Size of the counters in bytes, without the overflow table
+     */
+    std::size_t memory() const { return data.memory(); }
+
+  private:
+    CountingBitset<BPC> data;
+    std::unordered_map<std::size_t, std::size_t> overflow;
+};
 
 template <HashFamily H, std::size_t BPC = 4>
 class CountingBloomFilter {
@@ -32,9 +83,7 @@ class CountingBloomFilter {
             return;
         }
         for (auto &&h : hash_family.hash(key)) {
-            if (!data.is_stuck(_size.reduce(h))) {
-                data.decrement(_size.reduce(h));
-            }
+            data.decrement(_size.reduce(h));
         }
     }
     bool contains(const Kmer &key) const {
@@ -53,7 +102,7 @@ class CountingBloomFilter {
     }
 
   private:
-    CountingBitset<BPC> data;
+    OverflowCounters<BPC> data;
     Modulus _size;
     mutable H hash_family;
 };
@@ -69,39 +118,82 @@ class RollingCountingBloomFilter {
         std::size_t nhashes = std::round(std::log(2) * bits_per_element);
         return Self(size, nhashes, k, repr);
     }
+    /**
+     * @brief Filter of `size` counters with the number of hashes minimizing
+     * the error rate for `num_elements` elements
+     */
+    static Self for_size(std::size_t num_elements, std::size_t size,
+                         std::size_t k, KmerRepr repr) {
+        return Self(size, optimal_hashes(num_elements, size), k, repr);
+    }
+    /**
+     * @brief Filter of `bits` bits with the optimal number of hashes for
+     * `num_elements` elements
+     */
+    static Self for_memory(std::size_t num_elements, std::size_t bits,
+                           std::size_t k, KmerRepr repr) {
+        std::size_t size = bits / CountingBitset<BPC>::bits_per_counter();
+        return for_size(num_elements, std::max<std::size_t>(size, 1), k, repr);
+    }
     RollingCountingBloomFilter(std::size_t size, std::size_t nhashes,
                                std::size_t k, KmerRepr repr)
-        : _size(size), hash_family(nhashes, k, repr), data(size) {}
-    void init(const Kmer &key) { hash_family.init(key); }
-    void reset_hash_family() { hash_family.reset(); }
-    void roll(char c) { hash_family.roll(c); }
+        : _size(size), hash_family(nhashes, k, repr), data(size),
+          positions(nhashes) {}
+    void init(const Kmer &key) {
+        hash_family.init(key);
+        positions_valid = false;
+    }
+    void reset_hash_family() {
+        hash_family.reset();
+        positions_valid = false;
+    }
+    void roll(char c) { roll(char_to_nucleotide(c)); }
+    void roll(Nucleotide n) {
+        hash_family.roll(n);
+        positions_valid = false;
+    }
     void insert_this() {
         if (contains_this()) {
             return;
         }
-        for (auto &&h : hash_family.get_hashes()) {
-            data.increment(_size.reduce(h));
+        for (auto p : positions) {
+            data.increment(p);
         }
     }
     void erase_this() {
         if (!contains_this()) {
             return;
         }
-        for (auto &&h : hash_family.get_hashes()) {
-            if (!data.is_stuck(_size.reduce(h))) {
-                data.decrement(_size.reduce(h));
-            }
+        for (auto p : positions) {
+            data.decrement(p);
         }
     }
     bool contains_this() const {
+        update_positions();
         bool contains = true;
-        for (auto &&h : hash_family.get_hashes()) {
-            contains &= data.test(_size.reduce(h));
+        for (auto p : positions) {
+            contains &= data.test(p);
         }
         return contains;
     }
     static std::size_t bucket_size() { return BPC; }
+    /**
+     * @brief Bits spent per counter, for comparison with other filters
+     */
+    static double bits_per_cell() {
+        return CountingBitset<BPC>::bits_per_counter();
+    }
+    static const char *name() { return "Couting Bloom Filter"; }
+    std::size_t hashes() const { return hash_family.size(); }
     std::size_t size() const { return _size.get_mod(); }
+    /**
+     * @brief Size of the counters in bytes
+     */
+    std::size_t memory() const { return data.memory(); }
+    /**
+     * @brief Number of saturated counters with a count in the overflow table
+     */
+    std::size_t overflows() const { return data.overflows(); }
     double error_rate(std::size_t num_elements) const {
         std::size_t k = hash_family.size();
         double p = std::pow(
@@ -110,9 +202,26 @@ class RollingCountingBloomFilter {
     }
 
   private:
-    CountingBitset<BPC> data;
+    /**
+     * @brief Reduce the hashes of the current k-mer to counter positions once,
+     * the second phase queries and then updates the same k-mer
+     */
+    void update_positions() const {
+        if (positions_valid) {
+            return;
+        }
+        auto hashes = hash_family.get_hashes();
+        for (std::size_t i = 0; i < hashes.size(); i++) {
+            positions[i] = _size.reduce(hashes[i]);
+        }
+        positions_valid = true;
+    }
+
+    OverflowCounters<BPC> data;
     Modulus _size;
     H hash_family;
+    mutable std::vector<std::size_t> positions;
+    mutable bool positions_valid = false;
 };
 
 #endif
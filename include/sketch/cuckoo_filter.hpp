@@ -0,0 +1,276 @@
+#ifndef CUCKOO_FILTER_HPP
+#define CUCKOO_FILTER_HPP
+
+#include "hash/hash_family.hpp"
+#include "helper/page_memory.hpp"
+#include "math/modular.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+/**
+ * @brief Rolling cuckoo filter of k-mer fingerprints
+ *
+ * A k-mer is represented by a fingerprint of 4 to 30 bits, stored in one of
+ * the 4 slots of either of its two buckets. The alternative bucket is derived
+ * from the bucket and the fingerprint alone, so fingerprints can be relocated
+ * to make room. Buckets are bit-packed, so the fingerprints take all bits of
+ * the filter, and a lookup reads at most two buckets.
+ *
+ * An insertion failing after MAX_KICKS relocations drops a fingerprint. In the
+ * first phase, that only marks a later occurrence of the k-mer as present.
+ */
+template <RollingHashFamily H>
+class RollingCuckooFilter {
+    using Self = RollingCuckooFilter;
+    static constexpr std::size_t bucket_slots = 4;
+    static constexpr std::size_t min_fingerprint_bits = 4;
+    static constexpr std::size_t max_fingerprint_bits = 30;
+    static constexpr std::size_t MAX_KICKS = 500;
+    static constexpr double max_load = 0.95;
+
+  public:
+    /**
+     * @brief Filter of `size` bits with enough buckets for `num_elements`
+     * elements and the widest fingerprints fitting into the rest
+     */
+    static Self for_size(std::size_t num_elements, std::size_t size,
+                         std::size_t k, KmerRepr repr) {
+        std::size_t buckets = std::ceil(num_elements / max_load / bucket_slots);
+        buckets = std::max<std::size_t>(buckets, 1);
+        std::size_t bits = size / (buckets * bucket_slots);
+        if (bits < min_fingerprint_bits) {
+            bits = min_fingerprint_bits;
+            buckets = size / (bits * bucket_slots);
+        }
+        return Self(buckets, std::min(bits, max_fingerprint_bits), k, repr);
+    }
+    static const char *name() { return "Cuckoo Filter"; }
+
+    /**
+     * @param buckets Number of buckets of 4 fingerprints
+     * @param fingerprint_bits Width of the fingerprints, 4 to 30 bits
+     */
+    RollingCuckooFilter(std::size_t buckets, std::size_t fingerprint_bits,
+                        std::size_t k, KmerRepr repr)
+        : _buckets(std::max<std::size_t>(buckets, 1)),
+          fingerprint_bits(std::clamp(fingerprint_bits, min_fingerprint_bits,
+                                      max_fingerprint_bits)),
+          hash_family(2, k, repr),
+          // Padding for reading the last bucket as 16 bytes
+          data(allocate_zeroed<std::uint8_t>(bytes() + 16)) {}
+    std::size_t hashes() const { return 2; }
+    void init(const Kmer &key) {
+        hash_family.init(key);
+        positions_valid = false;
+    }
+    void reset_hash_family() {
+        hash_family.reset();
+        positions_valid = false;
+    }
+    void roll(char c) { roll(char_to_nucleotide(c)); }
+    void roll(Nucleotide n) {
+        hash_family.roll(n);
+        positions_valid = false;
+    }
+    void insert_this() {
+        update_positions();
+        insert(first, second, fingerprint);
+    }
+    void erase_this() {
+        update_positions();
+        for (auto bucket : {first, second}) {
+            for (std::size_t slot = 0; slot < bucket_slots; slot++) {
+                if (get(bucket, slot) == fingerprint) {
+                    set(bucket, slot, 0);
+                    _count--;
+                    return;
+                }
+            }
+        }
+    }
+    bool contains_this() const {
+        update_positions();
+        return contains(first, second, fingerprint);
+    }
+    /**
+     * @brief Number of values of the probe of a k-mer, its buckets and its
+     * fingerprint
+     */
+    std::size_t probe_size() const { return 3; }
+    /**
+     * @brief Write the buckets and the fingerprint of the current k-mer to
+     * `probe` and prefetch the buckets, so that the k-mer can be tested and
+     * inserted a few k-mers later by contains_probe and insert_probe
+     */
+    void prefetch_this(std::size_t *probe) const {
+        update_positions();
+        probe[0] = first;
+        probe[1] = second;
+        probe[2] = fingerprint;
+        __builtin_prefetch(data.get() + first * bucket_bits() / 8, 1);
+        __builtin_prefetch(data.get() + second * bucket_bits() / 8, 1);
+    }
+    bool contains_probe(const std::size_t *probe) const {
+        return contains(probe[0], probe[1], probe[2]);
+    }
+    void insert_probe(const std::size_t *probe) {
+        insert(probe[0], probe[1], probe[2]);
+    }
+    /**
+     * @brief Number of bits of the fingerprints
+     */
+    std::size_t size() const {
+        return _buckets.get_mod() * bucket_slots * fingerprint_bits;
+    }
+    double error_rate(std::size_t num_elements) const {
+        // Every fingerprint of the two buckets matches with probability
+        // 1/(2^f - 1)
+        double load = std::min(1.0, (double)num_elements / slots());
+        double compared = 2 * bucket_slots * load;
+        return 1 - std::pow(1 - 1 / (double)max_fingerprint(), compared);
+    }
+    /**
+     * @brief Fraction of used slots, the error rate is proportional to it
+     */
+    double fill_ratio() const { return (double)_count / slots(); }
+    /**
+     * @brief Number of fingerprints dropped after too many relocations
+     */
+    std::size_t dropped() const { return failures; }
+
+  private:
+    using bucket_t = unsigned __int128;
+
+    bool contains(std::size_t first, std::size_t second,
+                  std::uint32_t fp) const {
+        return find(read(first), fp) || find(read(second), fp);
+    }
+    void insert(std::size_t first, std::size_t second, std::uint32_t fp) {
+        if (contains(first, second, fp)) {
+            return;
+        }
+        if (put(first, fp) || put(second, fp)) {
+            _count++;
+            return;
+        }
+        // Evict fingerprints to their alternative buckets
+        std::size_t bucket = (kicks & 1) ? first : second;
+        for (std::size_t kick = 0; kick < MAX_KICKS; kick++) {
+            std::size_t slot = kicks++ % bucket_slots;
+            auto victim = get(bucket, slot);
+            set(bucket, slot, fp);
+            fp = victim;
+            bucket = alternative(bucket, fp);
+            if (put(bucket, fp)) {
+                _count++;
+                return;
+            }
+        }
+        failures++;
+    }
+
+    std::size_t slots() const { return _buckets.get_mod() * bucket_slots; }
+    std::size_t bucket_bits() const { return bucket_slots * fingerprint_bits; }
+    std::size_t bytes() const {
+        return (_buckets.get_mod() * bucket_bits() + 7) / 8;
+    }
+    std::uint32_t max_fingerprint() const {
+        return (1U << fingerprint_bits) - 1;
+    }
+    /**
+     * @brief The bits of a bucket, read with one unaligned load
+     */
+    bucket_t read(std::size_t bucket) const {
+        std::size_t bit = bucket * bucket_bits();
+        bucket_t word;
+        std::memcpy(&word, data.get() + bit / 8, sizeof(word));
+        return (word >> (bit % 8)) & (((bucket_t)1 << bucket_bits()) - 1);
+    }
+    void write(std::size_t bucket, bucket_t value) {
+        std::size_t bit = bucket * bucket_bits();
+        bucket_t word;
+        std::memcpy(&word, data.get() + bit / 8, sizeof(word));
+        bucket_t mask = (((bucket_t)1 << bucket_bits()) - 1) << (bit % 8);
+        word = (word & ~mask) | (value << (bit % 8));
+        std::memcpy(data.get() + bit / 8, &word, sizeof(word));
+    }
+    std::uint32_t get(std::size_t bucket, std::size_t slot) const {
+        return (read(bucket) >> (slot * fingerprint_bits)) & max_fingerprint();
+    }
+    void set(std::size_t bucket, std::size_t slot, std::uint32_t fp) {
+        auto value = read(bucket);
+        std::size_t shift = slot * fingerprint_bits;
+        value &= ~((bucket_t)max_fingerprint() << shift);
+        value |= (bucket_t)fp << shift;
+        write(bucket, value);
+    }
+    bool find(bucket_t bucket, std::uint32_t fp) const {
+        for (std::size_t slot = 0; slot < bucket_slots; slot++) {
+            if (((bucket >> (slot * fingerprint_bits)) & max_fingerprint()) ==
+                fp) {
+                return true;
+            }
+        }
+        return false;
+    }
+    /**
+     * @brief Store a fingerprint into an empty slot of a bucket, if any
+     */
+    bool put(std::size_t bucket, std::uint32_t fp) {
+        auto value = read(bucket);
+        for (std::size_t slot = 0; slot < bucket_slots; slot++) {
+            if (((value >> (slot * fingerprint_bits)) & max_fingerprint()) ==
+                0) {
+                set(bucket, slot, fp);
+                return true;
+            }
+        }
+        return false;
+    }
+    /**
+     * @brief The other bucket of a fingerprint, (hash(fp) - bucket) mod the
+     * number of buckets, which maps both buckets to each other
+     */
+    std::size_t alternative(std::size_t bucket, std::uint32_t fp) const {
+        std::size_t h = _buckets.reduce(fp * 0x5bd1e9955bd1e995ULL);
+        return h >= bucket ? h - bucket : h + _buckets.get_mod() - bucket;
+    }
+    /**
+     * @brief Derive the buckets and the fingerprint of the current k-mer once,
+     * the first phase queries and then inserts the same k-mer
+     */
+    void update_positions() const {
+        if (positions_valid) {
+            return;
+        }
+        auto hashes = hash_family.get_hashes();
+        // The MurMur3 finalizer, so that the fingerprint is independent of
+        // the remainder selecting the bucket
+        std::uint64_t x = hashes[0] ^ (hashes[1] << 24);
+        x ^= x >> 33;
+        x *= 0xff51afd7ed558ccdULL;
+        x ^= x >> 33;
+        x *= 0xc4ceb9fe1a85ec53ULL;
+        x ^= x >> 33;
+        fingerprint = x >> (64 - fingerprint_bits);
+        fingerprint += fingerprint == 0;
+        first = _buckets.reduce(hashes[0]);
+        second = alternative(first, fingerprint);
+        positions_valid = true;
+    }
+
+    Modulus _buckets;
+    std::size_t fingerprint_bits;
+    H hash_family;
+    page_ptr<std::uint8_t> data;
+    std::size_t _count = 0;
+    std::size_t failures = 0;
+    std::size_t kicks = 0;
+    mutable std::size_t first = 0, second = 0;
+    mutable std::uint32_t fingerprint = 0;
+    mutable bool positions_valid = false;
+};
+
+#endif
@@ -0,0 +1,198 @@
+#ifndef DLEFT_FILTER_HPP
+#define DLEFT_FILTER_HPP
+
+#include "hash/hash_family.hpp"
+#include "helper/page_memory.hpp"
+#include "math/modular.hpp"
+#include <bit>
+#include <cmath>
+#include <cstdint>
+#include <unordered_set>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+/**
+ * @brief Rolling d-left hashing filter of k-mer fingerprints, supporting
+ * deletions like the counting Bloom filter in less memory
+ *
+ * A k-mer is represented by a 16-bit fingerprint stored in one of two buckets,
+ * one in each half of the table, whichever holds fewer fingerprints (the left
+ * one on a tie). A bucket of 32 fingerprints spans a single cache line and is
+ * searched at once with SSE2, so an operation touches at most two cache lines.
+ * Insertions into two full buckets go to a small exact overflow set.
+ *
+ * Like the counting Bloom filter, the filter represents a set: a k-mer is only
+ * inserted if it is not contained, so the fingerprints need no counters.
+ */
+template <RollingHashFamily H>
+class RollingDLeftFilter {
+    using Self = RollingDLeftFilter;
+    using fingerprint_t = std::uint16_t;
+    static constexpr std::size_t tables = 2;
+    static constexpr std::size_t bucket_cells = 32;
+
+    struct alignas(64) Bucket {
+        fingerprint_t cells[bucket_cells];
+    };
+
+  public:
+    /**
+     * @brief Filter of at most `bits` bits, sized for `num_elements` elements
+     * by the caller
+     */
+    static Self for_memory(std::size_t, std::size_t bits, std::size_t k,
+                           KmerRepr repr) {
+        return Self(bits / (tables * sizeof(Bucket) * 8), k, repr);
+    }
+    /**
+     * @brief Bits spent per counter of a counting Bloom filter of the same
+     * error rate. At 20 bits per element, 80% of the cells are used and the
+     * error rate is below that of 10 counters per element.
+     */
+    static std::size_t bits_per_cell() { return 2; }
+    static const char *name() { return "d-left Filter"; }
+
+    /**
+     * @param buckets Number of buckets of each of the two tables
+     */
+    RollingDLeftFilter(std::size_t buckets, std::size_t k, KmerRepr repr)
+        : _buckets(std::max<std::size_t>(buckets, 1)),
+          hash_family(tables, k, repr),
+          data(allocate_zeroed<Bucket>(tables * _buckets.get_mod())) {}
+    void init(const Kmer &key) {
+        hash_family.init(key);
+        positions_valid = false;
+    }
+    void reset_hash_family() {
+        hash_family.reset();
+        positions_valid = false;
+    }
+    void roll(char c) { roll(char_to_nucleotide(c)); }
+    void roll(Nucleotide n) {
+        hash_family.roll(n);
+        positions_valid = false;
+    }
+    void insert_this() {
+        if (contains_this()) {
+            return;
+        }
+        auto empty_left = match(left(), 0);
+        auto empty_right = match(right(), 0);
+        bool use_right = std::popcount(empty_right) > std::popcount(empty_left);
+        auto &bucket = use_right ? right() : left();
+        auto empty = use_right ? empty_right : empty_left;
+        if (empty == 0) {
+            overflow.insert(overflow_key());
+            return;
+        }
+        bucket.cells[std::countr_zero(empty)] = fingerprint;
+    }
+    void erase_this() {
+        update_positions();
+        for (auto bucket : {&left(), &right()}) {
+            if (auto m = match(*bucket, fingerprint)) {
+                bucket->cells[std::countr_zero(m)] = 0;
+                return;
+            }
+        }
+        if (!overflow.empty()) {
+            overflow.erase(overflow_key());
+        }
+    }
+    bool contains_this() const {
+        update_positions();
+        if (match(left(), fingerprint) | match(right(), fingerprint)) {
+            return true;
+        }
+        return !overflow.empty() && overflow.contains(overflow_key());
+    }
+    std::size_t hashes() const { return tables; }
+    /**
+     * @brief Number of fingerprint cells
+     */
+    std::size_t size() const {
+        return tables * _buckets.get_mod() * bucket_cells;
+    }
+    /**
+     * @brief Size of the table in bytes
+     */
+    std::size_t memory() const {
+        return tables * _buckets.get_mod() * sizeof(Bucket);
+    }
+    /**
+     * @brief Number of fingerprints that did not fit into their buckets
+     */
+    std::size_t overflows() const { return overflow.size(); }
+    double error_rate(std::size_t num_elements) const {
+        // Every fingerprint of the two buckets matches with probability 1/2^16
+        double load = std::min(1.0, (double)num_elements / size());
+        double compared = tables * bucket_cells * load;
+        return 1 - std::pow(1 - 1.0 / 65535, compared);
+    }
+
+  private:
+    /**
+     * @brief Bit mask of the cells of a bucket equal to `fp`, zero for the
+     * empty cells
+     */
+    static std::uint32_t match(const Bucket &bucket, fingerprint_t fp) {
+#ifdef __SSE2__
+        auto cells = reinterpret_cast<const __m128i *>(bucket.cells);
+        auto needle = _mm_set1_epi16(fp);
+        std::uint32_t mask = 0;
+        for (std::size_t i = 0; i < 4; i += 2) {
+            auto lo = _mm_cmpeq_epi16(_mm_load_si128(cells + i), needle);
+            auto hi = _mm_cmpeq_epi16(_mm_load_si128(cells + i + 1), needle);
+            mask |= (std::uint32_t)_mm_movemask_epi8(_mm_packs_epi16(lo, hi))
+                    << (8 * i);
+        }
+        return mask;
+#else
+        std::uint32_t mask = 0;
+        for (std::size_t i = 0; i < bucket_cells; i++) {
+            mask |= (std::uint32_t)(bucket.cells[i] == fp) << i;
+        }
+        return mask;
+#endif
+    }
+    Bucket &left() const { return data[positions[0]]; }
+    Bucket &right() const { return data[positions[1]]; }
+    std::uint64_t overflow_key() const {
+        return (std::uint64_t)positions[0] << 16 | fingerprint;
+    }
+    /**
+     * @brief Derive the buckets and the fingerprint of the current k-mer once,
+     * the second phase queries and then updates the same k-mer
+     */
+    void update_positions() const {
+        if (positions_valid) {
+            return;
+        }
+        auto hashes = hash_family.get_hashes();
+        positions[0] = _buckets.reduce(hashes[0]);
+        positions[1] = _buckets.get_mod() + _buckets.reduce(hashes[1]);
+        // The MurMur3 finalizer, so that the fingerprint is independent of
+        // the remainders selecting the buckets
+        std::uint64_t x = hashes[0] ^ (hashes[1] << 24);
+        x ^= x >> 33;
+        x *= 0xff51afd7ed558ccdULL;
+        x ^= x >> 33;
+        x *= 0xc4ceb9fe1a85ec53ULL;
+        x ^= x >> 33;
+        fingerprint = x >> 48;
+        fingerprint += fingerprint == 0;
+        positions_valid = true;
+    }
+
+    Modulus _buckets;
+    H hash_family;
+    page_ptr<Bucket> data;
+    std::unordered_set<std::uint64_t> overflow;
+    mutable std::size_t positions[tables];
+    mutable fingerprint_t fingerprint = 0;
+    mutable bool positions_valid = false;
+};
+
+#endif
@@ -2,63 +2,129 @@
 #define HYPER_LOG_LOG_HPP
 
 #include "hash/hash_family.hpp"
-#include "helper/counting_bitset.hpp"
+#include "hash/mix_hash.hpp"
 #include "helper/kmer.hpp"
+#include <algorithm>
+#include <bit>
 #include <cmath>
+#include <cstdint>
+#include <limits>
+#include <numbers>
+#include <stdexcept>
+#include <vector>
 
-template <HashFamily H, std::size_t B = 12, std::size_t BPB = 5>
+/**
+ * @brief HyperLogLog estimate of the number of distinct k-mers
+ *
+ * A k-mer is hashed once, by default by mixing its integer representation. The
+ * top `precision` bits of the hash select one of 2^precision
+ * byte registers, which keeps the maximum rank (the position of the first set
+ * bit) of the remaining bits. The standard error is about 1.04 /
+ * sqrt(2^precision), 0.8% at the default precision of 14 with 16 KB of
+ * registers.
+ *
+ * The estimate is the improved estimator of Ertl[^ertl], computed from the
+ * histogram of the register values. It corrects the bias of the raw estimate
+ * for small and large cardinalities like HyperLogLog++, without its empirical
+ * bias tables and without switching to linear counting.
+ *
+ * [^ertl]: Otmar Ertl. New cardinality estimation algorithms for HyperLogLog
+ * sketches. arXiv:1702.01284, 2017.
+ */
+template <Hash H = mix_hash>
 class HyperLogLog {
-  private:
-    using Bitset = CountingBitset<BPB>;
-    static constexpr std::size_t buckets = (1 << B);
-    static constexpr std::size_t counter_max = (1 << BPB) - 1;
-    static constexpr std::size_t index_mask = (1 << B) - 1;
-    static constexpr double alpha = 0.7213 / (1 + 1.079 / buckets);
-
   public:
-    HyperLogLog(KmerRepr repr) : hash_family(1, repr), bitset(buckets) {}
-    void update(const Kmer &k) {
-        auto hash = hash_family.hash(k)[0];
-        auto index = hash & index_mask;
-        auto zeros = std::countl_zero(hash) + 1;
+    static constexpr std::size_t min_precision = 10;
+    static constexpr std::size_t max_precision = 18;
+    static constexpr std::size_t default_precision = 14;
 
-        if (bitset.get(index) < zeros) {
-            bitset.set(index, zeros);
+    /**
+     * @param precision Number of bits selecting a register, 10 to 18
+     */
+    explicit HyperLogLog(KmerRepr repr,
+                         std::size_t precision = default_precision)
+        : hash_function(42, repr),
+          _precision(std::clamp(precision, min_precision, max_precision)),
+          registers(1 << _precision, 0) {}
+    template <KmerType K>
+    void update(const K &k) {
+        std::uint64_t hash = hash_function.hash(k);
+        auto index = hash >> (64 - _precision);
+        // A sentinel bit caps the rank at 65 - precision
+        std::uint8_t rank =
+                std::countl_zero((hash << _precision) |
+                                 (1ULL << (_precision - 1))) +
+                1;
+        registers[index] = std::max(registers[index], rank);
+    }
+    /**
+     * @brief Add the k-mers of another sketch of the same precision, the
+     * register-wise maximum
+     */
+    void merge(const HyperLogLog &other) {
+        if (other._precision != _precision) {
+            throw std::invalid_argument(
+                    "Merging HyperLogLogs of different precisions");
+        }
+        for (std::size_t i = 0; i < registers.size(); i++) {
+            registers[i] = std::max(registers[i], other.registers[i]);
         }
     }
     std::size_t query() const {
-        auto hll_est = hll_estimate();
-        if (2 * hll_est <= 5 * buckets) {
-            return linear_estimate();
-        } else {
-            return hll_est;
+        std::size_t q = 64 - _precision;
+        std::vector<std::size_t> histogram(q + 2, 0);
+        for (auto rank : registers) {
+            histogram[rank]++;
         }
+        double m = registers.size();
+        double z = m * tau(1 - histogram[q + 1] / m);
+        for (std::size_t rank = q; rank >= 1; rank--) {
+            z = 0.5 * (z + histogram[rank]);
+        }
+        z += m * sigma(histogram[0] / m);
+        return static_cast<std::size_t>(alpha_inf * m * m / z);
     }
+    std::size_t precision() const { return _precision; }
 
   private:
-    std::size_t hll_estimate() const {
-        std::size_t sum = 0;
-        for (std::size_t i = 0; i < buckets; i++) {
-            sum += 1 << (counter_max - bitset.get(i));
+    static constexpr double alpha_inf = 0.5 / std::numbers::ln2;
+
+    /**
+     * @brief Correction for the empty registers, x + sum x^(2^k) 2^(k-1)
+     */
+    static double sigma(double x) {
+        if (x == 1) {
+            return std::numeric_limits<double>::infinity();
         }
-        std::size_t base = static_cast<std::size_t>(alpha * buckets * buckets);
-        return (base << counter_max) / sum;
+        double y = 1, z = x, previous;
+        do {
+            x *= x;
+            previous = z;
+            z += x * y;
+            y += y;
+        } while (z != previous);
+        return z;
     }
-    std::size_t linear_estimate() const {
-        std::size_t zero_count = 0;
-        for (std::size_t i = 0; i < buckets; i++) {
-            if (bitset.get(i) == 0) {
-                zero_count++;
-            }
+    /**
+     * @brief Correction for the saturated registers
+     */
+    static double tau(double x) {
+        if (x == 0 || x == 1) {
+            return 0;
         }
-        if (zero_count == 0) {
-            return buckets * std::log(buckets);
-        }
-        return static_cast<std::size_t>(
-                buckets * std::log(static_cast<double>(buckets) / zero_count));
+        double y = 1, z = 1 - x, previous;
+        do {
+            x = std::sqrt(x);
+            previous = z;
+            y *= 0.5;
+            z -= (1 - x) * (1 - x) * y;
+        } while (z != previous);
+        return z / 3;
     }
-    H hash_family;
-    Bitset bitset;
+
+    H hash_function;
+    std::size_t _precision;
+    std::vector<std::uint8_t> registers;
 };
 
 #endif
@@ -0,0 +1,37 @@
+#ifndef KMER_SAMPLER_HPP
+#define KMER_SAMPLER_HPP
+
+#include "hash/hash_family.hpp"
+#include "helper/kmer.hpp"
+#include <cmath>
+
+/**
+ * @brief Hash-based subsampling of k-mers
+ *
+ * A k-mer is sampled if its hash is below a threshold. The decision depends
+ * only on the k-mer, so the same k-mers are sampled in every file, and each
+ * k-mer is sampled with probability `rate`.
+ */
+template <HashFamily H>
+class KmerSampler {
+  public:
+    static constexpr std::uint64_t SEED = 7;
+
+    KmerSampler(double rate, KmerRepr repr)
+        : hash_family(1, SEED, repr), _rate(std::min(rate, 1.0)) {
+        threshold = _rate >= 1 ? UINT64_MAX
+                               : (std::uint64_t)std::ldexp(_rate, 64);
+    }
+    template <KmerType K>
+    bool contains(const K &kmer) {
+        return _rate >= 1 || hash_family.hash(kmer)[0] < threshold;
+    }
+    double rate() const { return _rate; }
+
+  private:
+    H hash_family;
+    double _rate;
+    std::uint64_t threshold;
+};
+
+#endif
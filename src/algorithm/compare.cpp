@@ -0,0 +1,229 @@
+#include "algorithm/compare.hpp"
+#include "hash/murmur_hash.hpp"
+#include "helper/kmer.hpp"
+#include "helper/radix_sort.hpp"
+#include "io/mapped_fasta.hpp"
+#include "sketch/kmer_sampler.hpp"
+#include <algorithm>
+#include <cctype>
+#include <filesystem>
+#include <thread>
+#include <vector>
+
+using namespace compare;
+
+namespace {
+
+constexpr std::size_t MAX_MULTIPLICITY = 8;
+
+using Sampler = KmerSampler<murmur_hash_family>;
+
+/**
+ * @brief Call `sink` for every sampled k-mer ending in the byte range [lo, hi)
+ * of the file, in order. If `masked`, only k-mers marked as present are
+ * reported.
+ */
+template <KmerType KmerT, class F>
+void for_each_kmer(const io::MappedFile &file,
+                   const std::vector<io::Segment> &segments, std::size_t lo,
+                   std::size_t hi, std::size_t K, KmerRepr repr, bool masked,
+                   Sampler sampler, F &&sink) {
+    if constexpr (KmerT::fixed_size != 0) {
+        K = KmerT::fixed_size;
+    }
+    struct Visitor {
+        void start(bool) {
+            kmer.reset();
+            mask = 0;
+        }
+        void base(Nucleotide n, char c, bool in_range) {
+            kmer.roll(n);
+            mask = (mask << 1) | (bool)std::isupper(c);
+            bool present = !masked || (mask & (1ULL << (K - 1))) != 0;
+            if (in_range && kmer.available() >= K && present &&
+                sampler.contains(kmer)) {
+                sink(kmer.data(repr));
+            }
+        }
+        void ambiguous(std::size_t, bool) { kmer.reset(); }
+
+        KmerT kmer;
+        std::uint64_t mask;
+        std::size_t K;
+        KmerRepr repr;
+        bool masked;
+        Sampler sampler;
+        F &sink;
+    };
+    io::visit_range(file, segments, lo, hi, K - 1,
+                    Visitor{KmerT(K), 0, K, repr, masked, std::move(sampler),
+                            sink});
+}
+
+/**
+ * @brief Extract all (present, if `masked`) k-mers of a file into a sorted
+ * array
+ */
+template <KmerType KmerT>
+std::vector<typename KmerT::data_t>
+sorted_kmers(const std::string &path, std::size_t K, KmerRepr repr,
+             bool masked, const Sampler &sampler, std::size_t threads) {
+    using key_t = typename KmerT::data_t;
+    io::MappedFile file(path);
+    auto segments = io::find_segments(file);
+    auto range = [&](std::size_t t) {
+        return std::make_pair(file.size() * t / threads,
+                              file.size() * (t + 1) / threads);
+    };
+
+    // Count the k-mers first, so that they can be written in place
+    std::vector<std::size_t> offsets(threads + 1, 0);
+    std::vector<std::thread> workers;
+    for (std::size_t t = 0; t < threads; t++) {
+        workers.emplace_back([&, t] {
+            auto [lo, hi] = range(t);
+            for_each_kmer<KmerT>(file, segments, lo, hi, K, repr, masked,
+                                 sampler, [&](key_t) { offsets[t + 1]++; });
+        });
+    }
+    for (auto &&worker : workers) {
+        worker.join();
+    }
+    for (std::size_t t = 0; t < threads; t++) {
+        offsets[t + 1] += offsets[t];
+    }
+
+    auto kmers = std::vector<key_t>(offsets[threads]);
+    workers.clear();
+    for (std::size_t t = 0; t < threads; t++) {
+        workers.emplace_back([&, t] {
+            auto [lo, hi] = range(t);
+            auto out = kmers.begin() + offsets[t];
+            for_each_kmer<KmerT>(file, segments, lo, hi, K, repr, masked,
+                                 sampler, [&](key_t kmer) { *out++ = kmer; });
+        });
+    }
+    for (auto &&worker : workers) {
+        worker.join();
+    }
+
+    radix_sort(kmers, 2 * K, threads);
+    return kmers;
+}
+
+/**
+ * @brief Merge-join sorted golden and output k-mers
+ */
+template <class Key>
+exact::Accuracy join(std::span<const Key> golden,
+                     std::span<const Key> output) {
+    exact::Accuracy result;
+    result.multiplicity.assign(MAX_MULTIPLICITY + 1, 0);
+    std::size_t g = 0, o = 0;
+    while (g < golden.size() || o < output.size()) {
+        bool in_golden = g < golden.size() &&
+                         (o == output.size() || golden[g] <= output[o]);
+        auto kmer = in_golden ? golden[g] : output[o];
+        std::size_t golden_count = 0, output_count = 0;
+        for (; g < golden.size() && golden[g] == kmer; g++) {
+            golden_count++;
+        }
+        for (; o < output.size() && output[o] == kmer; o++) {
+            output_count++;
+        }
+        result.present_kmers += golden_count > 0;
+        if (golden_count > 0 && output_count == 0) {
+            result.missing_kmers++;
+        }
+        if (golden_count > 0 && output_count > 0) {
+            result.additional_kmers += output_count - 1;
+        } else {
+            result.additional_kmers += output_count;
+        }
+        result.multiplicity[std::min(output_count, MAX_MULTIPLICITY)]++;
+    }
+    return result;
+}
+
+} // namespace
+
+template <KmerType KmerT>
+exact::Accuracy compare::sorted_accuracy(const CompareArgs &args) {
+    std::size_t K = KmerT::fixed_size ? KmerT::fixed_size : args.k();
+    auto threads = args.threads();
+    auto kmer_repr =
+            args.unidirectional() ? KmerRepr::FORWARD : KmerRepr::CANON;
+    auto full_memory = sizeof(typename KmerT::data_t) *
+                       (std::filesystem::file_size(args.reference()) +
+                        std::filesystem::file_size(args.output()));
+    Sampler sampler(sample_rate(args, full_memory), kmer_repr);
+    auto golden = sorted_kmers<KmerT>(args.reference(), K, kmer_repr,
+                               !args.has_input(), sampler, threads);
+    auto output = sorted_kmers<KmerT>(args.output(), K, kmer_repr, true,
+                                       sampler, threads);
+
+    // Split the key space between threads at the boundaries of golden k-mers
+    std::vector<std::size_t> golden_split(threads + 1, golden.size());
+    std::vector<std::size_t> output_split(threads + 1, output.size());
+    golden_split[0] = output_split[0] = 0;
+    for (std::size_t t = 1; t < threads && !golden.empty(); t++) {
+        auto pivot = golden[golden.size() * t / threads];
+        golden_split[t] = std::lower_bound(golden.begin(), golden.end(),
+                                           pivot) -
+                          golden.begin();
+        output_split[t] = std::lower_bound(output.begin(), output.end(),
+                                           pivot) -
+                          output.begin();
+    }
+
+    std::vector<exact::Accuracy> partial(threads);
+    std::vector<std::thread> workers;
+    for (std::size_t t = 0; t < threads; t++) {
+        workers.emplace_back([&, t] {
+            std::span<const typename KmerT::data_t> g(golden), o(output);
+            partial[t] = join(g.subspan(golden_split[t],
+                                        golden_split[t + 1] - golden_split[t]),
+                              o.subspan(output_split[t],
+                                        output_split[t + 1] - output_split[t]));
+        });
+    }
+    for (auto &&worker : workers) {
+        worker.join();
+    }
+
+    exact::Accuracy result;
+    result.multiplicity.assign(MAX_MULTIPLICITY + 1, 0);
+    result.sample_rate = sampler.rate();
+    for (auto &&p : partial) {
+        result.missing_kmers += p.missing_kmers;
+        result.additional_kmers += p.additional_kmers;
+        result.present_kmers += p.present_kmers;
+        for (std::size_t i = 0; i <= MAX_MULTIPLICITY; i++) {
+            result.multiplicity[i] += p.multiplicity[i];
+        }
+    }
+    return result;
+}
+
+
+template exact::Accuracy
+compare::sorted_accuracy<BasicKmer<15>>(const CompareArgs &);
+template exact::Accuracy
+compare::sorted_accuracy<BasicKmer<21>>(const CompareArgs &);
+template exact::Accuracy
+compare::sorted_accuracy<BasicKmer<25>>(const CompareArgs &);
+template exact::Accuracy
+compare::sorted_accuracy<BasicKmer<31>>(const CompareArgs &);
+template exact::Accuracy
+compare::sorted_accuracy<BasicKmer<32>>(const CompareArgs &);
+template exact::Accuracy compare::sorted_accuracy<Kmer>(const CompareArgs &);
+template exact::Accuracy
+compare::sorted_accuracy<WideKmer>(const CompareArgs &);
+
+double compare::sample_rate(const CompareArgs &args, std::size_t full_memory) {
+    double rate = args.sample_rate();
+    if (args.memory() > 0 && full_memory > 0) {
+        rate = std::min(rate, (double)args.memory() / full_memory);
+    }
+    return rate;
+}
@@ -1,62 +1,207 @@
 #include "algorithm/exact.hpp"
+#include "algorithm/approximate_count.hpp"
+#include "algorithm/compare.hpp"
+#include "hash/mix_hash.hpp"
+#include "hash/murmur_hash.hpp"
+#include "helper/kmer_set.hpp"
 #include "io/fasta.hpp"
-#include <unordered_set>
+#include "io/records.hpp"
+#include "sketch/kmer_sampler.hpp"
+#include <barrier>
+#include <cctype>
+#include <cmath>
+#include <filesystem>
+#include <functional>
+#include <iostream>
+#include <optional>
+#include <queue>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
 
 using namespace exact;
 
+/**
+ * @brief Print a count scaled by the sample rate with its 95% confidence
+ * interval, using the normal approximation of the binomial distribution
+ */
+void print_estimate(std::ostream &os, const std::string &name,
+                    std::size_t count, const Accuracy &acc) {
+    double p = acc.sample_rate;
+    double estimate = count / p;
+    double error = 1.96 * std::sqrt(std::max<double>(count, 1) * (1 - p)) / p;
+    double present = acc.present_kmers / p;
+    os << name << ": " << (std::size_t)estimate << " ± " << (std::size_t)error
+       << " / " << (std::size_t)present << " (" << estimate / present * 100
+       << "% ± " << error / present * 100 << "%)\n";
+}
+
 std::ostream &operator<<(std::ostream &os, const Accuracy &acc) {
-    double missing_percent =
-            (double)acc.missing_kmers / acc.present_kmers * 100;
-    double additional_percent =
-            (double)acc.additional_kmers / acc.present_kmers * 100;
-    os << "Missing kmers: " << acc.missing_kmers << " / " << acc.present_kmers
-       << " (" << missing_percent << "%)\n"
-       << "Additional kmers: " << acc.additional_kmers << " / "
-       << acc.present_kmers << " (" << additional_percent << "%)\n";
+    if (acc.sample_rate < 1) {
+        os << "Sampled " << acc.sample_rate * 100 << "% of kmers, "
+           << "estimates with 95% confidence intervals\n";
+        print_estimate(os, "Missing kmers", acc.missing_kmers, acc);
+        print_estimate(os, "Additional kmers", acc.additional_kmers, acc);
+    } else {
+        double missing_percent =
+                (double)acc.missing_kmers / acc.present_kmers * 100;
+        double additional_percent =
+                (double)acc.additional_kmers / acc.present_kmers * 100;
+        os << "Missing kmers: " << acc.missing_kmers << " / "
+           << acc.present_kmers << " (" << missing_percent << "%)\n"
+           << "Additional kmers: " << acc.additional_kmers << " / "
+           << acc.present_kmers << " (" << additional_percent << "%)\n";
+    }
+    if (acc.multiplicity.size() <= 2) {
+        return os;
+    }
+    std::size_t repeated = 0;
+    for (std::size_t i = 2; i < acc.multiplicity.size(); i++) {
+        repeated += acc.multiplicity[i];
+    }
+    os << "Kmers represented more than once: "
+       << (std::size_t)(repeated / acc.sample_rate) << "\n";
+    for (std::size_t i = 2; i < acc.multiplicity.size(); i++) {
+        if (acc.multiplicity[i] == 0) {
+            continue;
+        }
+        bool last = i + 1 == acc.multiplicity.size();
+        os << "    " << i << (last ? "+" : "") << " times: "
+           << (std::size_t)(acc.multiplicity[i] / acc.sample_rate) << "\n";
+    }
     return os;
 }
 
-Accuracy exact::compute_accuracy(const CompareArgs &args) {
-    auto K = args.k();
-    io::FastaReader output(args.output());
+namespace {
+
+using Sampler = KmerSampler<murmur_hash_family>;
+
+/**
+ * @brief Set of the integer representations of KmerT
+ */
+template <KmerType KmerT>
+using KmerSetFor = BasicKmerSet<typename KmerT::data_t>;
+
+/**
+ * @brief Set of the sampled present k-mers of the exact output
+ */
+template <KmerType KmerT>
+KmerSetFor<KmerT> golden_kmers(const CompareArgs &args, KmerRepr kmer_repr,
+                               Sampler &sampler) {
+    std::size_t K = KmerT::fixed_size ? KmerT::fixed_size : args.k();
     io::FastaReader golden_output(args.golden());
-    auto kmer_repr =
-            args.unidirectional() ? KmerRepr::FORWARD : KmerRepr::CANON;
-    std::unordered_set<Kmer::data_t> kmer_set;
-    Accuracy result;
 
+    // Every uppercase letter marks one present k-mer, so their count is an
+    // upper bound on the number of distinct present k-mers.
+    std::size_t marked_kmers = 0;
     while (golden_output.next_sequence()) {
-        Kmer kmer(K);
         char c;
-        std::size_t mask = 0;
         while (golden_output.next_nucleotide(c)) {
-            kmer.roll(c);
-            mask = (mask << 1) | (bool)std::isupper(c);
-            mask &= (1ULL << K) - 1;
-            bool present = (mask & (1ULL << (K - 1))) != 0;
-            if (kmer.available() >= K && present) {
-                kmer_set.insert(kmer.data(kmer_repr));
+            marked_kmers += (bool)std::isupper(c);
+        }
+    }
+    golden_output.reset();
+    KmerSetFor<KmerT> kmer_set((std::size_t)(marked_kmers * sampler.rate()));
+
+    std::string_view run;
+    std::vector<Nucleotide> bases;
+    while (golden_output.next_sequence()) {
+        KmerT kmer(K);
+        std::size_t mask = 0;
+        while (golden_output.next_bases(run, bases)) {
+            if (golden_output.ambiguous()) {
+                kmer.reset();
+                continue;
+            }
+            for (std::size_t i = 0; i < bases.size(); i++) {
+                kmer.roll(bases[i]);
+                mask = (mask << 1) | (bool)std::isupper(run[i]);
+                bool present = (mask & (1ULL << (K - 1))) != 0;
+                if (kmer.available() >= K && present &&
+                    sampler.contains(kmer)) {
+                    kmer_set.insert(kmer.data(kmer_repr));
+                }
             }
         }
     }
+    return kmer_set;
+}
+
+/**
+ * @brief Set of the sampled k-mers of the input FASTA
+ */
+template <KmerType KmerT>
+KmerSetFor<KmerT> input_kmers(const CompareArgs &args, KmerRepr kmer_repr,
+                              Sampler &sampler) {
+    std::size_t K = KmerT::fixed_size ? KmerT::fixed_size : args.k();
+    io::FastaReader in(args.input());
+    auto stats = approximate_count<mix_hash, KmerT>(
+            args.input(), K, kmer_repr,
+            HyperLogLog<mix_hash>::default_precision, args.threads());
+    auto expected =
+            (std::size_t)(stats.approximate_kmer_count * sampler.rate());
+    KmerSetFor<KmerT> kmer_set(expected + expected / 16);
+
+    std::string_view run;
+    std::vector<Nucleotide> bases;
+    while (in.next_sequence()) {
+        KmerT kmer(K);
+        while (in.next_bases(run, bases)) {
+            if (in.ambiguous()) {
+                kmer.reset();
+                continue;
+            }
+            for (auto n : bases) {
+                kmer.roll(n);
+                if (kmer.available() >= K && sampler.contains(kmer)) {
+                    kmer_set.insert(kmer.data(kmer_repr));
+                }
+            }
+        }
+    }
+    return kmer_set;
+}
+
+} // namespace
+
+template <KmerType KmerT>
+Accuracy exact::compute_accuracy(const CompareArgs &args) {
+    std::size_t K = KmerT::fixed_size ? KmerT::fixed_size : args.k();
+    io::FastaReader output(args.output());
+    auto kmer_repr =
+            args.unidirectional() ? KmerRepr::FORWARD : KmerRepr::CANON;
+    Accuracy result;
+    auto full_memory = KmerSetFor<KmerT>::memory_for(
+            std::filesystem::file_size(args.reference()));
+    Sampler sampler(compare::sample_rate(args, full_memory), kmer_repr);
+    KmerSetFor<KmerT> kmer_set = args.has_input()
+                               ? input_kmers<KmerT>(args, kmer_repr, sampler)
+                               : golden_kmers<KmerT>(args, kmer_repr, sampler);
+    result.sample_rate = sampler.rate();
 
     result.present_kmers = kmer_set.size();
 
+    std::string_view run;
+    std::vector<Nucleotide> bases;
     while (output.next_sequence()) {
-        Kmer kmer(K);
-        char c;
+        KmerT kmer(K);
         std::size_t mask = 0;
-        while (output.next_nucleotide(c)) {
-            kmer.roll(c);
-            mask = (mask << 1) | (bool)std::isupper(c);
-            mask &= (1ULL << K) - 1;
-            bool present = (mask & (1ULL << (K - 1))) != 0;
-            if (kmer.available() >= K && present) {
-                auto kmer_data = kmer.data(kmer_repr);
-                if (kmer_set.contains(kmer_data)) {
-                    kmer_set.erase(kmer_data);
-                } else {
-                    result.additional_kmers++;
+        while (output.next_bases(run, bases)) {
+            if (output.ambiguous()) {
+                kmer.reset();
+                continue;
+            }
+            for (std::size_t i = 0; i < bases.size(); i++) {
+                kmer.roll(bases[i]);
+                mask = (mask << 1) | (bool)std::isupper(run[i]);
+                bool present = (mask & (1ULL << (K - 1))) != 0;
+                if (kmer.available() >= K && present &&
+                    sampler.contains(kmer)) {
+                    if (!kmer_set.erase(kmer.data(kmer_repr))) {
+                        result.additional_kmers++;
+                    }
                 }
             }
         }
@@ -66,33 +211,595 @@ Accuracy exact::compute_accuracy(const CompareArgs &args) {
     return result;
 }
 
+namespace {
+
+constexpr std::uint8_t NO_KMER = 2;
+constexpr std::size_t BLOCK_SIZE = 1 << 20;
+
+/**
+ * @brief A chunk of the input stream, with the k-mer ending at every base and
+ * the decision whether it is its first occurrence
+ */
+template <class Key>
+struct Block {
+    std::vector<Nucleotide> bases;
+    std::vector<Key> kmers;
+    std::vector<std::uint8_t> marks;
+    // Positions in bases of the k-mers of every partition
+    std::vector<std::vector<std::uint32_t>> parts;
+    // Positions in bases before which a sequence or a part of it ends
+    std::vector<std::size_t> ends;
+    // Runs of ambiguous bases and the positions in bases before which they
+    // occur, always after an end at the same position
+    std::vector<std::pair<std::size_t, std::string>> ambiguous;
+
+    bool empty() const { return bases.empty() && ends.empty(); }
+    void clear() {
+        bases.clear();
+        kmers.clear();
+        marks.clear();
+        for (auto &part : parts) {
+            part.clear();
+        }
+        ends.clear();
+        ambiguous.clear();
+    }
+};
+
+/**
+ * @brief Partition of a k-mer, independent of the hash used inside KmerSet
+ */
+template <class Key>
+std::size_t partition(Key kmer, std::size_t partitions) {
+    std::uint64_t folded = kmer;
+    if constexpr (sizeof(Key) > sizeof(std::uint64_t)) {
+        folded ^= (std::uint64_t)(kmer >> 64) * 0xc2b2ae3d27d4eb4fULL;
+    }
+    auto hash = (folded * 0x9e3779b97f4a7c15ULL) >> 32;
+    return hash % partitions;
+}
+
+/**
+ * @brief Reader of the input in blocks, which assigns every k-mer to its
+ * partition once
+ */
+template <KmerType KmerT>
+class BlockReader {
+  public:
+    BlockReader(const std::string &path, std::size_t K, KmerRepr repr,
+                std::size_t partitions)
+        : in(path), kmer(K), repr(repr), partitions(partitions) {}
+    void fill(Block<typename KmerT::data_t> &block) {
+        block.clear();
+        block.parts.resize(partitions);
+        std::string_view run;
+        while (block.bases.size() < BLOCK_SIZE) {
+            if (!in_sequence) {
+                if (!in.next_sequence()) {
+                    return;
+                }
+                in_sequence = true;
+                kmer.reset();
+            }
+            if (!in.next_bases(run, bases)) {
+                in_sequence = false;
+                block.ends.push_back(block.bases.size());
+                continue;
+            }
+            if (in.ambiguous()) {
+                kmer.reset();
+                block.ends.push_back(block.bases.size());
+                block.ambiguous.emplace_back(block.bases.size(), run);
+                continue;
+            }
+            for (auto n : bases) {
+                kmer.roll(n);
+                auto data = kmer.data(repr);
+                if (kmer.available() < kmer.size()) {
+                    block.marks.push_back(NO_KMER);
+                } else {
+                    block.marks.push_back(io::NOT_PRESENT);
+                    block.parts[partition(data, partitions)].push_back(
+                            block.bases.size());
+                }
+                block.bases.push_back(n);
+                block.kmers.push_back(data);
+            }
+        }
+    }
+
+  private:
+    io::FastaReader in;
+    std::vector<Nucleotide> bases;
+    KmerT kmer;
+    KmerRepr repr;
+    std::size_t partitions;
+    bool in_sequence = false;
+};
+
+/**
+ * @brief Decide first occurrences of the k-mers of one partition. Every
+ * occurrence of a k-mer belongs to the same partition, so processing the
+ * partitions independently gives the same decisions as the serial scan.
+ */
+template <class Key>
+void process_partition(Block<Key> &block, BasicKmerSet<Key> &kmer_set,
+                       std::size_t part) {
+    for (auto i : block.parts[part]) {
+        block.marks[i] = kmer_set.insert(block.kmers[i]) ? io::PRESENT
+                                                         : io::NOT_PRESENT;
+    }
+}
+
+template <KmerType KmerT>
+void write_block(const Block<typename KmerT::data_t> &block,
+                 io::BasicKmerWriter<KmerT> &out) {
+    std::size_t e = 0, a = 0;
+    auto write_breaks = [&](std::size_t i) {
+        for (; e < block.ends.size() && block.ends[e] <= i; e++) {
+            out.flush();
+        }
+        for (; a < block.ambiguous.size() && block.ambiguous[a].first <= i;
+             a++) {
+            out.print_ambiguous(block.ambiguous[a].second);
+        }
+    };
+    for (std::size_t i = 0; i < block.bases.size(); i++) {
+        write_breaks(i);
+        out.add_nucleotide(block.bases[i]);
+        if (block.marks[i] != NO_KMER) {
+            out.print_nucleotide(block.marks[i]);
+        }
+    }
+    write_breaks(block.bases.size());
+}
+
+/**
+ * @brief Exact algorithm with k-mers partitioned by hash between threads
+ *
+ * Blocks of the input are processed in a pipeline: while the workers decide
+ * the first occurrences in one block, the main thread writes the previous
+ * block and reads the next one. The workers live for the whole input and
+ * meet the main thread at a barrier before and after every block.
+ */
+template <KmerType KmerT>
+int compute_superstring_parallel(const ExactArgs &args) {
+    std::size_t K = KmerT::fixed_size ? KmerT::fixed_size : args.k();
+    auto partitions = args.threads();
+    auto kmer_repr =
+            args.unidirectional() ? KmerRepr::FORWARD : KmerRepr::CANON;
+    BlockReader<KmerT> in(args.dataset(), K, kmer_repr, partitions);
+    io::BasicKmerWriter<KmerT> out(args.output(), K, args.splice());
+    out.write_header(args.fasta_header());
+    auto stats = approximate_count<mix_hash, KmerT>(
+            args.dataset(), K, kmer_repr,
+            HyperLogLog<mix_hash>::default_precision, args.threads());
+    std::size_t per_partition = stats.approximate_kmer_count / partitions;
+    std::vector<KmerSetFor<KmerT>> kmer_sets;
+    for (std::size_t i = 0; i < partitions; i++) {
+        kmer_sets.emplace_back(per_partition + per_partition / 16);
+    }
+
+    using Key = typename KmerT::data_t;
+    Block<Key> blocks[3];
+    Block<Key> *current = nullptr;
+    bool done = false;
+    std::barrier sync(partitions + 1);
+    std::vector<std::thread> workers;
+    for (std::size_t i = 0; i < partitions; i++) {
+        workers.emplace_back([&, i] {
+            while (true) {
+                sync.arrive_and_wait();
+                if (done) {
+                    return;
+                }
+                process_partition(*current, kmer_sets[i], i);
+                sync.arrive_and_wait();
+            }
+        });
+    }
+
+    in.fill(blocks[0]);
+    for (std::size_t b = 0;; b++) {
+        current = &blocks[b % 3];
+        Block<Key> &next = blocks[(b + 1) % 3];
+        Block<Key> &previous = blocks[(b + 2) % 3];
+        bool last = current->empty();
+        if (!last) {
+            sync.arrive_and_wait();
+        }
+        if (b > 0) {
+            write_block(previous, out);
+        }
+        if (last) {
+            break;
+        }
+        in.fill(next);
+        sync.arrive_and_wait();
+    }
+    done = true;
+    sync.arrive_and_wait();
+    for (auto &&worker : workers) {
+        worker.join();
+    }
+    return 0;
+}
+
+template <class Key>
+struct Occurrence {
+    Key kmer;
+    std::uint64_t position;
+};
+
+constexpr std::size_t MAX_BUCKETS = 512;
+// The smallest buffer of a bucket file, in records
+constexpr std::size_t MIN_BUFFER = 16;
+constexpr std::size_t MAX_BUFFER = 4096;
+// Sub-partitions of a bucket, the unit of splitting an overfull bucket
+constexpr std::size_t SUB_PARTITIONS = 256;
+
+std::string bucket_name(const ExactArgs &args, std::size_t bucket) {
+    return args.tmp_prefix() + "." + std::to_string(bucket);
+}
+
+std::string first_name(const ExactArgs &args, std::size_t bucket,
+                       std::size_t pass) {
+    return bucket_name(args, bucket) + ".first." + std::to_string(pass);
+}
+
+/**
+ * @brief Sub-partition of a k-mer within its bucket, from other bits of the
+ * k-mer than partition
+ */
+template <class Key>
+std::size_t sub_partition(Key kmer) {
+    std::uint64_t folded = kmer;
+    if constexpr (sizeof(Key) > sizeof(std::uint64_t)) {
+        folded ^= (std::uint64_t)(kmer >> 64) * 0x9e3779b97f4a7c15ULL;
+    }
+    return (folded * 0xc2b2ae3d27d4eb4fULL) >> 56;
+}
+
+/**
+ * @brief Capacity of the k-mer set of a bucket with `mean` expected
+ * occurrences, with headroom of four standard deviations of the number of
+ * k-mers hashed into it
+ */
+std::size_t bucket_capacity(std::size_t mean) {
+    return mean + 4 * (std::size_t)std::sqrt((double)mean) + 16;
+}
+
+/**
+ * @brief Number of buckets, capacity of their k-mer sets and records per
+ * bucket buffer within a budget
+ */
+struct BucketPlan {
+    std::size_t buckets;
+    std::size_t capacity;
+    std::size_t buffer_size;
+};
+
+/**
+ * @brief Split the budget between the k-mer set of a bucket and the buffers
+ * of the bucket files, an eighth of it
+ * @return Nothing if the budget needs more than MAX_BUCKETS buckets or leaves
+ * fewer than MIN_BUFFER records per buffer
+ */
+template <KmerType KmerT>
+std::optional<BucketPlan> plan_buckets(std::size_t max_kmers,
+                                       std::size_t memory) {
+    using Key = typename KmerT::data_t;
+    std::size_t buffers = memory / 8;
+    std::size_t set_memory = memory - buffers;
+    std::size_t needed = KmerSetFor<KmerT>::memory_for(max_kmers);
+    std::size_t buckets = std::max<std::size_t>(
+            1, (needed + set_memory - 1) / set_memory);
+    auto capacity = [&] {
+        return bucket_capacity((max_kmers + buckets - 1) / buckets);
+    };
+    // The headroom and the rounding of the set to whole groups can need a
+    // few more buckets
+    while (buckets <= MAX_BUCKETS &&
+           KmerSetFor<KmerT>::memory_for(capacity()) > set_memory) {
+        buckets++;
+    }
+    if (buckets > MAX_BUCKETS) {
+        return std::nullopt;
+    }
+    std::size_t buffer_size = std::min(
+            MAX_BUFFER, buffers / (buckets * sizeof(Occurrence<Key>)));
+    if (buffer_size < MIN_BUFFER) {
+        return std::nullopt;
+    }
+    return BucketPlan{buckets, capacity(), buffer_size};
+}
+
+/**
+ * @brief The smallest budget for which plan_buckets succeeds, up to a
+ * hundredth
+ */
+template <KmerType KmerT>
+std::size_t minimum_memory(std::size_t max_kmers, std::size_t memory) {
+    std::size_t lo = memory, hi = std::max<std::size_t>(memory, 1);
+    while (!plan_buckets<KmerT>(max_kmers, hi)) {
+        lo = hi;
+        hi *= 2;
+    }
+    while (hi - lo > hi / 100) {
+        std::size_t mid = lo + (hi - lo) / 2;
+        (plan_buckets<KmerT>(max_kmers, mid) ? hi : lo) = mid;
+    }
+    return hi;
+}
+
+/**
+ * @brief The temporary files created so far, removed also when an error
+ * interrupts the algorithm
+ */
+struct BucketFiles {
+    std::vector<std::string> paths;
+
+    std::string add(const std::string &path) {
+        paths.push_back(path);
+        return path;
+    }
+    ~BucketFiles() {
+        std::error_code ignored;
+        for (auto &path : paths) {
+            std::filesystem::remove(path, ignored);
+        }
+    }
+};
+
+/**
+ * @brief Split a bucket into passes over ranges of its sub-partitions, so
+ * that the occurrences of each pass, and thus its distinct k-mers, fit into
+ * `capacity`. A single pass unless the bucket outgrew its plan.
+ */
+template <class Key>
+std::vector<std::pair<std::size_t, std::size_t>>
+plan_passes(const std::string &bucket, std::size_t occurrences,
+            std::size_t capacity, std::size_t buffer_size) {
+    if (occurrences <= capacity) {
+        return {{0, SUB_PARTITIONS}};
+    }
+    std::vector<std::size_t> counts(SUB_PARTITIONS, 0);
+    io::RecordReader<Occurrence<Key>> in(bucket, buffer_size);
+    Occurrence<Key> occurrence;
+    while (in.next(occurrence)) {
+        counts[sub_partition(occurrence.kmer)]++;
+    }
+    // A sub-partition above the capacity still gets a pass of its own
+    std::vector<std::pair<std::size_t, std::size_t>> passes;
+    std::size_t begin = 0, count = 0;
+    for (std::size_t s = 0; s < SUB_PARTITIONS; s++) {
+        if (s > begin && count + counts[s] > capacity) {
+            passes.emplace_back(begin, s);
+            begin = s;
+            count = 0;
+        }
+        count += counts[s];
+    }
+    passes.emplace_back(begin, SUB_PARTITIONS);
+    return passes;
+}
+
+/**
+ * @brief Exact algorithm with the k-mer set bounded by a memory budget
+ *
+ * The occurrences of k-mers (k-mer, index of the occurrence) are distributed
+ * into buckets on disk by hash, so that the distinct k-mers of each bucket fit
+ * into a KmerSet within the budget. Each bucket is read in the order of the
+ * occurrences and the indices of first occurrences are written to a sorted
+ * file. The final pass over the input merges these files to mark the k-mers.
+ *
+ * An eighth of the budget is kept for the buffers of the bucket files, and at
+ * most MAX_BUCKETS buckets are used, so a budget too small for the input is
+ * reported with the smallest one sufficient. The set of a bucket is reserved
+ * with headroom for the imbalance of the hash and never grows: a bucket with
+ * more occurrences than that is split into several passes over parts of its
+ * k-mers. Failing to write or read the bucket files throws
+ * std::runtime_error.
+ */
+template <KmerType KmerT>
+int compute_superstring_external(const ExactArgs &args) {
+    std::size_t K = KmerT::fixed_size ? KmerT::fixed_size : args.k();
+    auto kmer_repr =
+            args.unidirectional() ? KmerRepr::FORWARD : KmerRepr::CANON;
+    using Key = typename KmerT::data_t;
+
+    // The size of the input bounds the number of k-mer occurrences
+    std::size_t max_kmers = std::filesystem::file_size(args.dataset());
+    auto plan = plan_buckets<KmerT>(max_kmers, args.memory());
+    if (!plan) {
+        std::cerr << "Memory budget too small for the input, at least "
+                  << minimum_memory<KmerT>(max_kmers, args.memory())
+                  << " bytes needed" << std::endl;
+        return 1;
+    }
+    auto [bucket_count, capacity, buffer_size] = *plan;
+    BucketFiles files;
+
+    std::vector<std::size_t> bucket_sizes(bucket_count, 0);
+    {
+        std::vector<io::RecordWriter<Occurrence<Key>>> buckets;
+        for (std::size_t b = 0; b < bucket_count; b++) {
+            buckets.emplace_back(files.add(bucket_name(args, b)),
+                                 buffer_size);
+        }
+        io::FastaReader in(args.dataset());
+        std::uint64_t position = 0;
+        std::string_view run;
+        std::vector<Nucleotide> bases;
+        while (in.next_sequence()) {
+            KmerT kmer(K);
+            while (in.next_bases(run, bases)) {
+                if (in.ambiguous()) {
+                    kmer.reset();
+                    continue;
+                }
+                for (auto n : bases) {
+                    kmer.roll(n);
+                    if (kmer.available() < K) {
+                        continue;
+                    }
+                    auto data = kmer.data(kmer_repr);
+                    auto b = partition(data, bucket_count);
+                    buckets[b].push({data, position++});
+                    bucket_sizes[b]++;
+                }
+            }
+        }
+        for (auto &bucket : buckets) {
+            bucket.flush();
+        }
+    }
+
+    std::vector<std::string> first_names;
+    for (std::size_t b = 0; b < bucket_count; b++) {
+        auto passes = plan_passes<Key>(bucket_name(args, b), bucket_sizes[b],
+                                       capacity, buffer_size);
+        for (std::size_t pass = 0; pass < passes.size(); pass++) {
+            auto [begin, end] = passes[pass];
+            io::RecordReader<Occurrence<Key>> in(bucket_name(args, b),
+                                                 buffer_size);
+            first_names.push_back(files.add(first_name(args, b, pass)));
+            io::RecordWriter<std::uint64_t> out(first_names.back(),
+                                                buffer_size);
+            KmerSetFor<KmerT> kmer_set(std::min(bucket_sizes[b], capacity));
+            Occurrence<Key> occurrence;
+            while (in.next(occurrence)) {
+                auto s = sub_partition(occurrence.kmer);
+                if (s >= begin && s < end &&
+                    kmer_set.insert(occurrence.kmer)) {
+                    out.push(occurrence.position);
+                }
+            }
+            out.flush();
+        }
+        std::filesystem::remove(bucket_name(args, b));
+    }
+
+    using Head = std::pair<std::uint64_t, std::size_t>;
+    std::vector<io::RecordReader<std::uint64_t>> firsts;
+    std::priority_queue<Head, std::vector<Head>, std::greater<Head>> heads;
+    for (std::size_t f = 0; f < first_names.size(); f++) {
+        firsts.emplace_back(first_names[f], buffer_size);
+        std::uint64_t position;
+        if (firsts[f].next(position)) {
+            heads.emplace(position, f);
+        }
+    }
+
+    io::FastaReader in(args.dataset());
+    io::BasicKmerWriter<KmerT> out(args.output(), K, args.splice());
+    out.write_header(args.fasta_header());
+    std::uint64_t position = 0;
+    std::string_view run;
+    std::vector<Nucleotide> bases;
+    while (in.next_sequence()) {
+        KmerT kmer(K);
+        while (in.next_bases(run, bases)) {
+            if (in.ambiguous()) {
+                kmer.reset();
+                out.flush();
+                out.print_ambiguous(run);
+                continue;
+            }
+            for (auto n : bases) {
+                kmer.roll(n);
+                out.add_nucleotide(n);
+                if (kmer.available() < K) {
+                    continue;
+                }
+                if (!heads.empty() && heads.top().first == position) {
+                    auto b = heads.top().second;
+                    heads.pop();
+                    std::uint64_t next;
+                    if (firsts[b].next(next)) {
+                        heads.emplace(next, b);
+                    }
+                    out.print_nucleotide(io::PRESENT);
+                } else {
+                    out.print_nucleotide(io::NOT_PRESENT);
+                }
+                position++;
+            }
+        }
+        out.flush();
+    }
+    return 0;
+}
+
+} // namespace
+
+template <KmerType KmerT>
 int exact::compute_superstring(const ExactArgs &args) {
-    auto K = args.k();
+    if (args.memory() > 0) {
+        try {
+            return compute_superstring_external<KmerT>(args);
+        } catch (const std::runtime_error &e) {
+            std::cerr << e.what() << std::endl;
+            return 1;
+        }
+    }
+    if (args.threads() > 1) {
+        return compute_superstring_parallel<KmerT>(args);
+    }
+    std::size_t K = KmerT::fixed_size ? KmerT::fixed_size : args.k();
     io::FastaReader in(args.dataset());
-    io::KmerWriter out(args.output(), K, args.splice());
+    io::BasicKmerWriter<KmerT> out(args.output(), K, args.splice());
     auto kmer_repr =
             args.unidirectional() ? KmerRepr::FORWARD : KmerRepr::CANON;
     out.write_header(args.fasta_header());
-    std::unordered_set<Kmer::data_t> kmer_set;
+    auto stats = approximate_count<mix_hash, KmerT>(
+            args.dataset(), K, kmer_repr,
+            HyperLogLog<mix_hash>::default_precision, args.threads());
+    // Leave some slack for the error of the estimate, the set can still grow
+    KmerSetFor<KmerT> kmer_set(stats.approximate_kmer_count +
+                     stats.approximate_kmer_count / 16);
 
+    std::string_view run;
+    std::vector<Nucleotide> bases;
     while (in.next_sequence()) {
-        Kmer kmer(K);
-        char c;
-        while (in.next_nucleotide(c)) {
-            kmer.roll(c);
-            out.add_nucleotide(c);
-            if (kmer.available() < K) {
+        KmerT kmer(K);
+        while (in.next_bases(run, bases)) {
+            if (in.ambiguous()) {
+                kmer.reset();
+                out.flush();
+                out.print_ambiguous(run);
                 continue;
             }
-            auto kmer_data = kmer.data(kmer_repr);
-            if (kmer_set.contains(kmer_data)) {
-                out.print_nucleotide(io::NOT_PRESENT);
-            } else {
-                out.print_nucleotide(io::PRESENT);
-                kmer_set.insert(kmer_data);
+            for (auto n : bases) {
+                kmer.roll(n);
+                out.add_nucleotide(n);
+                if (kmer.available() < K) {
+                    continue;
+                }
+                if (kmer_set.insert(kmer.data(kmer_repr))) {
+                    out.print_nucleotide(io::PRESENT);
+                } else {
+                    out.print_nucleotide(io::NOT_PRESENT);
+                }
             }
         }
         out.flush();
     }
     return 0;
 }
+
+template Accuracy exact::compute_accuracy<BasicKmer<15>>(const CompareArgs &);
+template Accuracy exact::compute_accuracy<BasicKmer<21>>(const CompareArgs &);
+template Accuracy exact::compute_accuracy<BasicKmer<25>>(const CompareArgs &);
+template Accuracy exact::compute_accuracy<BasicKmer<31>>(const CompareArgs &);
+template Accuracy exact::compute_accuracy<BasicKmer<32>>(const CompareArgs &);
+template Accuracy exact::compute_accuracy<Kmer>(const CompareArgs &);
+template Accuracy exact::compute_accuracy<WideKmer>(const CompareArgs &);
+
+template int exact::compute_superstring<BasicKmer<15>>(const ExactArgs &);
+template int exact::compute_superstring<BasicKmer<21>>(const ExactArgs &);
+template int exact::compute_superstring<BasicKmer<25>>(const ExactArgs &);
+template int exact::compute_superstring<BasicKmer<31>>(const ExactArgs &);
+template int exact::compute_superstring<BasicKmer<32>>(const ExactArgs &);
+template int exact::compute_superstring<Kmer>(const ExactArgs &);
+template int exact::compute_superstring<WideKmer>(const ExactArgs &);
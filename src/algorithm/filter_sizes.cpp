@@ -0,0 +1,38 @@
+#include "algorithm/filter_sizes.hpp"
+#include <algorithm>
+
+namespace {
+
+// The error rate is below 1e-5 at this size, more memory would only slow down
+// the filters with more hashes
+constexpr std::size_t MAX_BITS_PER_ELEMENT = 24;
+
+std::size_t cells_for(std::size_t elements, double cells_per_element) {
+    cells_per_element = std::min<double>(cells_per_element,
+                                         MAX_BITS_PER_ELEMENT);
+    return std::max<std::size_t>(1, elements * cells_per_element);
+}
+
+} // namespace
+
+FilterSizes filter_sizes(const ComputeArgs &args, std::size_t kmers,
+                         std::size_t duplicates, double cell_bits) {
+    kmers = std::max<std::size_t>(kmers, 1);
+    duplicates = std::max<std::size_t>(duplicates, 1);
+    if (args.memory() == 0) {
+        return {kmers * args.bits_per_element(),
+                (std::size_t)(duplicates * args.bits_per_element() *
+                              cell_bits)};
+    }
+    double bits = args.memory() * 8.0;
+    if (!args.fused()) {
+        return {cells_for(kmers, bits / kmers),
+                (std::size_t)(cells_for(duplicates,
+                                        bits / cell_bits / duplicates) *
+                              cell_bits)};
+    }
+    double cells_per_element = bits / (kmers + cell_bits * duplicates);
+    return {cells_for(kmers, cells_per_element),
+            (std::size_t)(cells_for(duplicates, cells_per_element) *
+                          cell_bits)};
+}
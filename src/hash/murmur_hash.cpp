@@ -4,8 +4,8 @@ constexpr std::uint64_t m = 0xc6a4a7935bd1e995ULL;
 constexpr std::uint32_t r = 47;
 constexpr std::uint64_t mask = 0xff;
 
-murmur_hash::hash_t murmur_hash_impl(const void *data, std::size_t size,
-                                     std::size_t seed) {
+std::uint64_t murmur_hash_impl(const void *data, std::size_t size,
+                               std::size_t seed) {
     murmur_hash::hash_t h = seed ^ (size * m);
 
     const uint64_t *data1 = (const uint64_t *)data;
@@ -49,23 +49,9 @@ murmur_hash::hash_t murmur_hash_impl(const void *data, std::size_t size,
     return h;
 }
 
-murmur_hash::hash_t murmur_hash::hash(const Kmer &key) const {
-    return murmur_hash_impl(&key.data(repr), sizeof(key.data(repr)), _seed);
-}
-
 murmur_hash_family::murmur_hash_family(std::size_t nhashes, std::uint64_t seed,
                                        KmerRepr repr)
     : hash_family(nhashes), xhash(seed, repr), yhash(seed + 1, repr) {}
 
 murmur_hash_family::murmur_hash_family(std::size_t nhashes, KmerRepr repr)
     : murmur_hash_family(nhashes, 42, repr) {}
-
-std::span<const murmur_hash_family::hash_t>
-murmur_hash_family::hash_impl(const Kmer &kmer) {
-    auto x = xhash.hash(kmer);
-    auto y = yhash.hash(kmer);
-    for (std::size_t i = 0; i < nhashes; i++) {
-        buffer[i] = x + i * y;
-    }
-    return std::span(buffer.get(), nhashes);
-}
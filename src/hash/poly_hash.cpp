@@ -39,21 +39,11 @@ poly_hash::poly_hash(std::uint64_t p, std::uint64_t _mod, std::size_t k)
     reset();
 }
 
-constexpr std::uint64_t NVALUE[] = {1, 2, 3, 4, 0};
-
-void poly_hash::init(const Kmer &kmer) {
+void poly_hash::set_size(std::size_t size) {
     reset();
-    k = kmer.size();
+    k = size;
     last_exp = pow_mod(p, k, mod);
     inv_p = pow_mod(p, mod.get_mod() - 2, mod);
-    for (int i = kmer.size() - 1; i >= 0; i--) {
-        auto nucleotide = kmer.get(i, KmerRepr::FORWARD);
-        auto rnucleotide = kmer.get(i, KmerRepr::REVERSE);
-        state = mod.reduce2((uint128_t)state * p + NVALUE[nucleotide]);
-        rev_state = mod.reduce2((uint128_t)rev_state * p + NVALUE[rnucleotide]);
-    }
-    state = mod.reduce(state);
-    rev_state = mod.reduce(rev_state);
 }
 
 void poly_hash::roll(Nucleotide n_in, Nucleotide n_out) {
@@ -74,44 +64,3 @@ void poly_hash::reset() {
     state = 0;
     rev_state = 0;
 }
-
-poly_hash_family::poly_hash_family(std::size_t nhashes, std::size_t k,
-                                   KmerRepr repr)
-    : rolling_hash_family(nhashes), repr(repr), kmer(k), xhash(k, 0),
-      yhash(k, 1) {}
-
-poly_hash_family::poly_hash_family(std::size_t nhashes, KmerRepr repr)
-    : poly_hash_family(nhashes, 0, repr) {}
-
-void poly_hash_family::roll_impl(char c) {
-    Nucleotide n_in = char_to_nucleotide(c);
-    Nucleotide n_out = kmer.last(KmerRepr::FORWARD);
-    kmer.roll(c);
-    xhash.roll(n_in, n_out);
-    yhash.roll(n_in, n_out);
-
-    update_hashes();
-}
-
-void poly_hash_family::init_impl(const Kmer &key) {
-    kmer = key;
-    xhash.init(kmer);
-    yhash.init(kmer);
-
-    update_hashes();
-}
-
-void poly_hash_family::reset_impl() {
-    xhash.reset();
-    yhash.reset();
-    kmer.reset();
-}
-
-void poly_hash_family::update_hashes() {
-    bool use_reverse = kmer.use_reverse(repr);
-    auto x = xhash.get_hash(use_reverse);
-    auto y = yhash.get_hash(use_reverse);
-    for (std::size_t i = 0; i < nhashes; i++) {
-        buffer[i] = x + i * y;
-    }
-}
@@ -1,11 +1,15 @@
 #include "helper/args.hpp"
+#include "helper/kmer.hpp"
+#include <algorithm>
 #include <filesystem>
 #include <iomanip>
 #include <iostream>
 #include <sstream>
+#include <stdexcept>
 #include <string>
 #include <unordered_map>
 #include <unordered_set>
+#include <vector>
 
 using opt_set = std::unordered_set<std::string>;
 using opt_map = std::unordered_map<std::string, std::string>;
@@ -43,21 +47,26 @@ bool next_opt(std::string *&begin, const std::string *end, std::string &opt,
     return false;
 }
 
-std::optional<std::pair<std::string, std::string>>
-parse_args(int argc, std::string *argv, const opt_set &opts,
-           const opt_set &flags, opt_map &opt_vals) {
+std::vector<std::string> parse_opts(int argc, std::string *argv,
+                                    const opt_set &opts, const opt_set &flags,
+                                    opt_map &opt_vals) {
     auto begin = argv;
     auto end = argv + argc;
     std::string opt, val;
     while (next_opt(begin, end, opt, val, opts, flags)) {
         opt_vals[opt] = val;
     }
-    if (end - begin != 2) {
+    return std::vector<std::string>(begin, end);
+}
+
+std::optional<std::pair<std::string, std::string>>
+parse_args(int argc, std::string *argv, const opt_set &opts,
+           const opt_set &flags, opt_map &opt_vals) {
+    auto args = parse_opts(argc, argv, opts, flags, opt_vals);
+    if (args.size() != 2) {
         return std::nullopt;
     }
-    auto first = *(begin++);
-    auto second = *(begin++);
-    return std::make_pair(first, second);
+    return std::make_pair(args[0], args[1]);
 }
 
 std::string get_tmp_file_name(const std::string &input) {
@@ -69,12 +78,127 @@ std::string get_tmp_file_name(const std::string &input) {
            tmp_file_filename;
 }
 
+/**
+ * @brief Parse a size in bytes with an optional K, M or G suffix
+ */
+std::size_t parse_size(const std::string &s) {
+    std::size_t pos;
+    std::size_t size = std::stoull(s, &pos);
+    std::string suffix = s.substr(pos);
+    if (suffix == "K") {
+        return size << 10;
+    }
+    if (suffix == "M") {
+        return size << 20;
+    }
+    if (suffix == "G") {
+        return size << 30;
+    }
+    if (!suffix.empty()) {
+        throw std::invalid_argument("Invalid size suffix");
+    }
+    return size;
+}
+
+HugePages parse_huge_pages(const std::string &s) {
+    if (s == "none") {
+        return HugePages::NONE;
+    }
+    if (s == "transparent") {
+        return HugePages::TRANSPARENT;
+    }
+    if (s == "explicit") {
+        return HugePages::EXPLICIT;
+    }
+    throw std::invalid_argument("Invalid huge page mode");
+}
+
+FirstPhaseFilter parse_first_phase_filter(const std::string &s) {
+    if (s == "bloom") {
+        return FirstPhaseFilter::BLOOM;
+    }
+    if (s == "cuckoo") {
+        return FirstPhaseFilter::CUCKOO;
+    }
+    throw std::invalid_argument("Invalid first phase filter");
+}
+
+SecondPhaseFilter parse_second_phase_filter(const std::string &s) {
+    if (s == "counting") {
+        return SecondPhaseFilter::COUNTING_BLOOM;
+    }
+    if (s == "dleft") {
+        return SecondPhaseFilter::DLEFT;
+    }
+    throw std::invalid_argument("Invalid second phase filter");
+}
+
+std::size_t parse_counter_bits(const std::string &s) {
+    std::size_t bits = std::stoul(s);
+    if (bits != 3 && bits != 4) {
+        throw std::invalid_argument("Invalid counter bits");
+    }
+    return bits;
+}
+
+std::size_t parse_hll_precision(const std::string &s) {
+    std::size_t precision = std::stoul(s);
+    if (precision < 10 || precision > 18) {
+        throw std::invalid_argument("Invalid HyperLogLog precision");
+    }
+    return precision;
+}
+
+/**
+ * @brief Parse a comma separated list of distinct k-mer sizes
+ */
+std::vector<std::size_t> parse_kmer_sizes(const std::string &s) {
+    std::vector<std::size_t> ks;
+    std::stringstream ss(s);
+    std::string k;
+    while (std::getline(ss, k, ',')) {
+        ks.push_back(std::stoul(k));
+        if (ks.back() > MAX_KMER_SIZE ||
+            std::count(ks.begin(), ks.end(), ks.back()) > 1) {
+            throw std::invalid_argument("Invalid k-mer size");
+        }
+    }
+    if (ks.empty()) {
+        throw std::invalid_argument("No k-mer size");
+    }
+    return ks;
+}
+
+/**
+ * @brief Insert ".k<size>" before the extension of a path
+ */
+std::string with_kmer_size_suffix(const std::string &path, std::size_t k) {
+    if (path.empty()) {
+        return path;
+    }
+    std::filesystem::path p(path);
+    auto name = p.stem().string() + ".k" + std::to_string(k) +
+                p.extension().string();
+    return p.replace_filename(name).string();
+}
+
 std::optional<ComputeArgs> ComputeArgs::from_cmdline(int argc,
                                                      std::string *argv) {
-    const opt_set opts = {"-k", "-bpk", "-t"};
-    const opt_set flags = {"-u", "-s", "--no-splice", "-f", "-v"};
-    std::unordered_map<std::string, std::string> opt_vals = {{"-k", "31"},
-                                                             {"-bpk", "10"}};
+    const opt_set opts = {"-k", "-bpk", "-M", "-t", "--huge-pages",
+                          "--first-filter", "--second-filter",
+                          "--counter-bits", "--hll-precision", "-j"};
+    const opt_set flags = {"-u", "-s", "--no-splice", "-f", "--fused",
+                           "--exact-correction", "--kmer-cache", "-v"};
+    std::unordered_map<std::string, std::string> opt_vals = {
+            {"-k", "31"},
+            {"-bpk", "10"},
+            {"-M", "0"},
+            {"--huge-pages", "transparent"},
+            {"--first-filter", "bloom"},
+            {"--second-filter", "counting"},
+            {"--counter-bits", "4"},
+            {"--hll-precision", "14"},
+            {"-j", "1"}};
     auto args = parse_args(argc, argv, opts, flags, opt_vals);
     if (!args.has_value()) {
         return std::nullopt;
@@ -91,16 +215,25 @@ std::optional<ComputeArgs> ComputeArgs::from_cmdline(int argc,
     }
 
     try {
-        std::size_t k = std::stoul(opt_vals.at("-k"));
-        if (k > 32) {
+        std::size_t threads = std::stoul(opt_vals.at("-j"));
+        if (threads == 0) {
             return std::nullopt;
         }
-
         return ComputeArgs(
-                k, std::stoul(opt_vals.at("-bpk")), opt_vals.contains("-u"),
+                parse_kmer_sizes(opt_vals.at("-k")),
+                std::stoul(opt_vals.at("-bpk")), parse_size(opt_vals.at("-M")),
+                parse_huge_pages(opt_vals.at("--huge-pages")),
+                parse_first_phase_filter(opt_vals.at("--first-filter")),
+                parse_second_phase_filter(opt_vals.at("--second-filter")),
+                parse_counter_bits(opt_vals.at("--counter-bits")),
+                parse_hll_precision(opt_vals.at("--hll-precision")), threads,
+                opt_vals.contains("-u"),
                 opt_vals.contains("-s") || opt_vals.contains("--no-splice"),
-                opt_vals.contains("-f"), opt_vals.contains("-v"),
-                std::move(input), std::move(first_out), std::move(second_out));
+                opt_vals.contains("-f"), opt_vals.contains("--fused"),
+                opt_vals.contains("--exact-correction"),
+                opt_vals.contains("--kmer-cache"),
+                opt_vals.contains("-v"), std::move(input), std::move(first_out),
+                std::move(second_out));
     } catch (...) {
         return std::nullopt;
     }
@@ -110,47 +243,85 @@ int ComputeArgs::usage() {
     // clang-format off
     std::cerr << "Usage: streaming-masked-superstrings compute [options] <input-fasta> <output-fasta>" << std::endl;
     std::cerr << "Options:" << std::endl;
-    std::cerr << "  -k <int>         kmer size [up to 32] (default = 31)" << std::endl;
+    std::cerr << "  -k <int>[,<int>] kmer size [up to 64] (default = 31); several sizes are computed" << std::endl;
+    std::cerr << "                   in one pass over the input, with '.k<size>' added to the outputs" << std::endl;
     std::cerr << "  -bpk <int>       bits per kmer (default = 10)" << std::endl;
+    std::cerr << "  -M <size>        memory budget of the filters, e.g. 512M or 8G, instead of -bpk" << std::endl;
     std::cerr << "  -t <path>        path to the temporary file used in second phase" << std::endl;
+    std::cerr << "  --huge-pages <mode>  back the filters by huge pages: none, transparent (default)" << std::endl;
+    std::cerr << "                   or explicit (hugetlbfs pool, falls back to transparent)" << std::endl;
+    std::cerr << "  --first-filter <type>   filter of the first phase: bloom (default) or cuckoo" << std::endl;
+    std::cerr << "                   (fingerprints, smaller below about 0.2% error rate, -bpk 13)" << std::endl;
+    std::cerr << "  --second-filter <type>  filter of the second phase: counting (Bloom, default)" << std::endl;
+    std::cerr << "                   or dleft (fingerprints, about half the memory)" << std::endl;
+    std::cerr << "  --counter-bits <int>  bits per counter of the counting filter: 3 or 4 (default)" << std::endl;
+    std::cerr << "  --hll-precision <int>  bits of the HyperLogLog estimating the number of kmers:" << std::endl;
+    std::cerr << "                   10 to 18 (default = 14), 2^<int> bytes, error about 100/2^(<int>/2)%" << std::endl;
+    std::cerr << "  -j <int>         number of threads estimating the number of kmers (default = 1)" << std::endl;
     std::cerr << "  -u               treat kmer and its reverse complement as distinct" << std::endl;
     std::cerr << "  -s, --no-splice  do not splice the resulting masked superstring" << std::endl;
     std::cerr << "  -f               run only the first phase of the algorithm" << std::endl;
-    std::cerr << "  -v               output sizes of Bloom Filters" << std::endl;
+    std::cerr << "  --fused          build the second phase filter during the first phase" << std::endl;
+    std::cerr << "  --exact-correction  correct with an exact k-mer set if the k-mers left" << std::endl;
+    std::cerr << "                   lowercase by the first phase fit into the memory of the filter (not with --fused)" << std::endl;
+    std::cerr << "  --kmer-cache     skip the first phase filter for k-mers repeated shortly after" << std::endl;
+    std::cerr << "                   (tandem repeats, low-complexity regions)" << std::endl;
+    std::cerr << "  -v               output sizes of Bloom Filters and page faults (always with -M)" << std::endl;
     // clang-format on
     return 1;
 }
 
+ComputeArgs ComputeArgs::for_k(std::size_t k) const {
+    ComputeArgs args = *this;
+    args._ks = {k};
+    args._memory = _memory / _ks.size();
+    if (_ks.size() > 1) {
+        args._first_out = with_kmer_size_suffix(_first_out, k);
+        args._second_out = with_kmer_size_suffix(_second_out, k);
+    }
+    return args;
+}
+
 std::string ComputeArgs::fasta_header() const {
     std::string mode = _unidirectional ? "unidirectional" : "bidirectional";
     std::string splice = _no_splice ? "false" : "true";
     std::stringstream ss;
-    ss << "approximate masked superstring dataset='" << _dataset << "' k=" << _k
-       << " bits-per-kmer=" << _bpk << " mode=" << mode << " splice=" << splice;
+    ss << "approximate masked superstring dataset='" << _dataset
+       << "' k=" << k() << " bits-per-kmer=" << _bpk << " mode=" << mode
+       << " splice=" << splice;
     return ss.str();
 }
 
 std::optional<ExactArgs> ExactArgs::from_cmdline(int argc, std::string *argv) {
-    const opt_set opts = {"-k"};
+    const opt_set opts = {"-k", "-j", "-M", "-t"};
     const opt_set flags = {"-u", "-s", "--no-splice"};
-    std::unordered_map<std::string, std::string> opt_vals = {{"-k", "31"}};
+    std::unordered_map<std::string, std::string> opt_vals = {
+            {"-k", "31"}, {"-j", "1"}, {"-M", "0"}};
 
     auto args = parse_args(argc, argv, opts, flags, opt_vals);
     if (!args.has_value()) {
         return std::nullopt;
     }
     auto [input, output] = args.value();
+    std::string tmp = opt_vals.contains("-t") ? opt_vals.at("-t")
+                                              : get_tmp_file_name(input);
 
     try {
         std::size_t k = std::stoul(opt_vals.at("-k"));
-        if (k > 32) {
+        if (k > MAX_KMER_SIZE) {
             return std::nullopt;
         }
 
-        return ExactArgs(k, opt_vals.contains("-u"),
+        std::size_t threads = std::stoul(opt_vals.at("-j"));
+        if (threads == 0) {
+            return std::nullopt;
+        }
+
+        return ExactArgs(k, threads, parse_size(opt_vals.at("-M")),
+                         opt_vals.contains("-u"),
                          opt_vals.contains("-s") ||
                                  opt_vals.contains("--no-splice"),
-                         std::move(input), std::move(output));
+                         std::move(input), std::move(output), std::move(tmp));
     } catch (...) {
         return std::nullopt;
     }
@@ -160,7 +331,11 @@ int ExactArgs::usage() {
     // clang-format off
     std::cerr << "Usage: streaming-masked-superstrings exact [options] <input-fasta> <output-fasta>" << std::endl;
     std::cerr << "Options:" << std::endl;
-    std::cerr << "  -k <int>         kmer size [up to 32] (default = 31)" << std::endl;
+    std::cerr << "  -k <int>         kmer size [up to 64] (default = 31)" << std::endl;
+    std::cerr << "  -j <int>         number of worker threads (default = 1)" << std::endl;
+    std::cerr << "  -M <size>        memory budget, e.g. 512M or 8G; k-mers are bucketed on disk" << std::endl;
+    std::cerr << "                   (at most 512 buckets; a budget too small reports the minimum)" << std::endl;
+    std::cerr << "  -t <path>        prefix of the temporary bucket files used with -M" << std::endl;
     std::cerr << "  -u               treat kmer and its reverse complement as distinct" << std::endl;
     std::cerr << "  -s, --no-splice  do not splice the resulting masked superstring" << std::endl;
     // clang-format on
@@ -178,24 +353,42 @@ std::string ExactArgs::fasta_header() const {
 
 std::optional<CompareArgs> CompareArgs::from_cmdline(int argc,
                                                      std::string *argv) {
-    const opt_set opts = {"-k"};
-    const opt_set flags = {"-u"};
-    std::unordered_map<std::string, std::string> opt_vals = {};
+    const opt_set opts = {"-k", "-j", "--input", "--sample", "-M"};
+    const opt_set flags = {"-u", "--sort"};
+    std::unordered_map<std::string, std::string> opt_vals = {
+            {"-j", "1"}, {"--sample", "1"}, {"-M", "0"}};
 
-    auto args = parse_args(argc, argv, opts, flags, opt_vals);
-    if (!args.has_value()) {
+    // With --input, the reference k-mers are read from the input FASTA
+    // instead of the exact output
+    auto args = parse_opts(argc, argv, opts, flags, opt_vals);
+    std::size_t positional = opt_vals.contains("--input") ? 1 : 2;
+    if (args.size() != positional) {
         return std::nullopt;
     }
-    auto [output, golden_output] = args.value();
+    std::string output = args[0];
+    std::string golden_output = positional == 2 ? args[1] : "";
+    std::string input = positional == 1 ? opt_vals.at("--input") : "";
 
     try {
         std::size_t k = std::stoul(opt_vals.at("-k"));
-        if (k > 32) {
+        if (k > MAX_KMER_SIZE) {
+            return std::nullopt;
+        }
+
+        std::size_t threads = std::stoul(opt_vals.at("-j"));
+        if (threads == 0) {
+            return std::nullopt;
+        }
+
+        double sample_rate = std::stod(opt_vals.at("--sample"));
+        if (sample_rate <= 0 || sample_rate > 1) {
             return std::nullopt;
         }
 
-        return CompareArgs(k, opt_vals.contains("-u"), std::move(output),
-                           std::move(golden_output));
+        return CompareArgs(k, threads, opt_vals.contains("-u"),
+                           opt_vals.contains("--sort"), sample_rate,
+                           parse_size(opt_vals.at("-M")), std::move(output),
+                           std::move(golden_output), std::move(input));
     } catch (...) {
         return std::nullopt;
     }
@@ -204,9 +397,15 @@ std::optional<CompareArgs> CompareArgs::from_cmdline(int argc,
 int CompareArgs::usage() {
     // clang-format off
     std::cerr << "Usage: streaming-masked-superstrings compare [options] <approximate-output> <exact-output>" << std::endl;
+    std::cerr << "       streaming-masked-superstrings compare [options] --input <input-fasta> <approximate-output>" << std::endl;
     std::cerr << "Options:" << std::endl;
-    std::cerr << "  -k <int>         kmer size [up to 32]" << std::endl;
+    std::cerr << "  -k <int>         kmer size [up to 64]" << std::endl;
+    std::cerr << "  -j <int>         number of threads used with --sort (default = 1)" << std::endl;
     std::cerr << "  -u               treat kmer and its reverse complement as distinct" << std::endl;
+    std::cerr << "  --sort           compare sorted arrays of kmers instead of a hash set" << std::endl;
+    std::cerr << "  --input <path>   compare against all kmers of the input FASTA" << std::endl;
+    std::cerr << "  --sample <float> compare only this fraction of kmers and estimate the rest" << std::endl;
+    std::cerr << "  -M <size>        memory budget, e.g. 512M or 8G; lowers the sampled fraction" << std::endl;
     // clang-format on
     return 1;
 }
@@ -1,33 +1,72 @@
 #include "helper/bitset.hpp"
+#include <bit>
+#include <stdexcept>
 
-std::size_t align_up(std::size_t size, std::size_t align) {
-    return (size + align - 1) & ~(align - 1);
+namespace {
+
+using word_t = DynamicBitset::word_t;
+
+std::size_t count_scalar(std::span<const word_t> words) {
+    std::size_t count = 0;
+    for (auto word : words) {
+        count += std::popcount(word);
+    }
+    return count;
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+/**
+ * @brief The same loop compiled with the POPCNT instruction, which the
+ * baseline x86-64 target lacks
+ */
+__attribute__((target("popcnt"))) std::size_t
+count_popcnt(std::span<const word_t> words) {
+    std::size_t count = 0;
+    for (auto word : words) {
+        count += __builtin_popcountll(word);
+    }
+    return count;
 }
+#endif
+
+void check_sizes(const DynamicBitset &a, const DynamicBitset &b) {
+    if (a.size() != b.size()) {
+        throw std::invalid_argument("Bitsets of different sizes");
+    }
+}
+
+} // namespace
 
 DynamicBitset::DynamicBitset(std::size_t size) : _size(size) {
-    std::size_t bit_size = align_up(size, inner_size);
-    std::size_t inner_count = (bit_size + inner_size - 1) / inner_size;
-    data = std::make_unique<inner_t[]>(inner_count);
-    std::fill(data.get(), data.get() + inner_count, 0);
+    data = allocate_zeroed<word_t>(word_count());
 }
 
-void DynamicBitset::set(std::size_t ind) {
-    if (ind >= _size) {
-        return;
+std::size_t DynamicBitset::count() const {
+#if defined(__x86_64__) || defined(__i386__)
+    static const bool has_popcnt = __builtin_cpu_supports("popcnt");
+    if (has_popcnt) {
+        return count_popcnt(words());
     }
-    data[ind / inner_size] |= (1 << (ind % inner_size));
+#endif
+    return count_scalar(words());
 }
 
-void DynamicBitset::reset(std::size_t ind) {
-    if (ind >= _size) {
-        return;
+DynamicBitset &DynamicBitset::operator|=(const DynamicBitset &other) {
+    check_sizes(*this, other);
+    auto to = words();
+    auto from = other.words();
+    for (std::size_t i = 0; i < to.size(); i++) {
+        to[i] |= from[i];
     }
-    data[ind / inner_size] &= ~(1 << (ind % inner_size));
+    return *this;
 }
 
-bool DynamicBitset::test(std::size_t ind) const {
-    if (ind >= _size) {
-        return false;
+DynamicBitset &DynamicBitset::operator&=(const DynamicBitset &other) {
+    check_sizes(*this, other);
+    auto to = words();
+    auto from = other.words();
+    for (std::size_t i = 0; i < to.size(); i++) {
+        to[i] &= from[i];
     }
-    return data[ind / inner_size] & (1 << (ind % inner_size));
+    return *this;
 }
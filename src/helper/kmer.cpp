@@ -1,80 +1,96 @@
 #include "helper/kmer.hpp"
 
+#include <bit>
 #include <stdexcept>
-#include <utility>
 
-using data_t = Kmer::data_t;
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
 
-Nucleotide char_to_nucleotide(char c) {
-    switch (c) {
-    case 'A':
-    case 'a':
-        return A;
-    case 'C':
-    case 'c':
-        return C;
-    case 'G':
-    case 'g':
-        return G;
-    case 'T':
-    case 't':
-        return T;
-    case 'N':
-        return N;
-    default:
-        throw std::invalid_argument("Invalid nucleotide character");
-    }
+void throw_invalid_nucleotide() {
+    throw std::invalid_argument("Invalid nucleotide character");
 }
 
-Kmer::Kmer(const std::string &kmer) {
-    K = kmer.size();
-    _data = 0;
-    _rev_data = 0;
-    for (std::size_t i = 0; i < kmer.size(); i++) {
-        _data |= char_to_nucleotide(kmer[i]) << (2 * (K - 1 - i));
-        _rev_data |= COMPLEMENT[char_to_nucleotide(kmer[i])] << (2 * i);
+namespace {
+
+std::size_t encode_scalar(const char *in, std::size_t n, Nucleotide *out) {
+    for (std::size_t i = 0; i < n; i++) {
+        auto code = NUCLEOTIDE_CODES[(std::uint8_t)in[i]];
+        if (code > T) {
+            return i;
+        }
+        out[i] = (Nucleotide)code;
     }
-    n_count = kmer.size();
+    return n;
 }
 
-void Kmer::roll(char c) {
-    _data <<= 2;
-    _data |= char_to_nucleotide(c);
-    _data &= ((1ULL << (2 * K)) - 1);
-
-    _rev_data >>= 2;
-    _rev_data |= (data_t)COMPLEMENT[char_to_nucleotide(c)] << (2 * (K - 1));
-
-    n_count++;
+#if defined(__x86_64__) || defined(__i386__)
+/**
+ * @brief Encode 16 characters per step with a byte shuffle. The low nibble of
+ * each letter is distinct among A, C, G and T, so it indexes a table of codes
+ * and a second table of the expected uppercase letters, which validates the
+ * input.
+ */
+__attribute__((target("ssse3"))) std::size_t
+encode_ssse3(const char *in, std::size_t n, Nucleotide *out) {
+    const __m128i codes = _mm_setr_epi8(0, A, 0, C, T, 0, 0, G, 0, 0, 0, 0,
+                                        0, 0, 0, 0);
+    const __m128i letters = _mm_setr_epi8(-1, 'A', -1, 'C', 'T', -1, -1, 'G',
+                                          -1, -1, -1, -1, -1, -1, -1, -1);
+    const __m128i nibble = _mm_set1_epi8(0x0f);
+    const __m128i upper = _mm_set1_epi8((char)0xdf);
+    std::size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i *>(in + i));
+        __m128i index = _mm_and_si128(c, nibble);
+        __m128i valid = _mm_cmpeq_epi8(_mm_and_si128(c, upper),
+                                       _mm_shuffle_epi8(letters, index));
+        if (_mm_movemask_epi8(valid) != 0xffff) {
+            break;
+        }
+        __m128i code = _mm_shuffle_epi8(codes, index);
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(out + i), code);
+    }
+    return i + encode_scalar(in + i, n - i, out + i);
 }
+#endif
 
-Nucleotide Kmer::get(std::size_t i, KmerRepr representation) const {
-    if (i >= K || i >= n_count) {
-        return Nucleotide::N;
+std::size_t skip_ambiguous_scalar(const char *in, std::size_t n) {
+    for (std::size_t i = 0; i < n; i++) {
+        if (NUCLEOTIDE_CODES[(std::uint8_t)in[i]] != N) {
+            return i;
+        }
     }
-    return static_cast<Nucleotide>((data(representation) >> (i * 2)) & 0b11);
+    return n;
 }
 
-const data_t &Kmer::data(KmerRepr representation) const {
-    switch (representation) {
-    case KmerRepr::FORWARD:
-        return _data;
-    case KmerRepr::REVERSE:
-        return _rev_data;
-    case KmerRepr::CANON:
-        return _data < _rev_data ? _data : _rev_data;
+} // namespace
+
+std::size_t skip_ambiguous(const char *in, std::size_t n) {
+    std::size_t i = 0;
+#ifdef __SSE2__
+    // Runs of N are the common case and can be megabases long
+    const __m128i upper = _mm_set1_epi8((char)0xdf);
+    const __m128i letter_n = _mm_set1_epi8('N');
+    for (; i + 16 <= n; i += 16) {
+        __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i *>(in + i));
+        auto is_n = (std::uint32_t)_mm_movemask_epi8(
+                _mm_cmpeq_epi8(_mm_and_si128(c, upper), letter_n));
+        if (is_n != 0xffff) {
+            i += std::countr_one(is_n);
+            break;
+        }
     }
-    std::unreachable();
+#endif
+    return i + skip_ambiguous_scalar(in + i, n - i);
 }
 
-bool Kmer::use_reverse(KmerRepr representation) const {
-    switch (representation) {
-    case KmerRepr::FORWARD:
-        return false;
-    case KmerRepr::REVERSE:
-        return true;
-    case KmerRepr::CANON:
-        return _data > _rev_data;
+std::size_t encode_nucleotides(const char *in, std::size_t n, Nucleotide *out) {
+#if defined(__x86_64__) || defined(__i386__)
+    static const bool has_ssse3 = __builtin_cpu_supports("ssse3");
+    if (has_ssse3) {
+        return encode_ssse3(in, n, out);
     }
-    std::unreachable();
+#endif
+    return encode_scalar(in, n, out);
 }
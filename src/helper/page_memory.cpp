@@ -0,0 +1,149 @@
+#include "helper/page_memory.hpp"
+#include <cstdlib>
+#include <fstream>
+#include <limits>
+#include <new>
+#include <string>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+HugePages huge_pages = HugePages::TRANSPARENT;
+
+} // namespace
+
+void set_huge_pages(HugePages policy) { huge_pages = policy; }
+
+#ifdef __linux__
+
+namespace {
+
+constexpr std::size_t HUGE_PAGE_SIZE = 2 << 20;
+
+std::size_t align_up(std::size_t size, std::size_t align) {
+    return (size + align - 1) / align * align;
+}
+
+} // namespace
+
+void *allocate_zeroed_pages(std::size_t &bytes) {
+    if (bytes == 0) {
+        return nullptr;
+    }
+    if (huge_pages == HugePages::EXPLICIT && bytes >= HUGE_PAGE_SIZE) {
+        std::size_t huge_bytes = align_up(bytes, HUGE_PAGE_SIZE);
+        void *data = mmap(nullptr, huge_bytes, PROT_READ | PROT_WRITE,
+                          MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if (data != MAP_FAILED) {
+            bytes = huge_bytes;
+            return data;
+        }
+    }
+    void *data = mmap(nullptr, bytes, PROT_READ | PROT_WRITE,
+                      MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (data == MAP_FAILED) {
+        throw std::bad_alloc();
+    }
+    if (huge_pages != HugePages::NONE && bytes >= HUGE_PAGE_SIZE) {
+        // Only a hint, the allocation is still valid if it fails
+        madvise(data, bytes, MADV_HUGEPAGE);
+    }
+    return data;
+}
+
+void PageDeleter::operator()(void *data) const {
+    if (data != nullptr) {
+        munmap(data, bytes);
+    }
+}
+
+TlbCounter::TlbCounter() {
+    perf_event_attr attr{};
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HW_CACHE;
+    attr.config = PERF_COUNT_HW_CACHE_DTLB |
+                  (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                  (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    fd = syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+}
+
+TlbCounter::~TlbCounter() {
+    if (fd >= 0) {
+        close(fd);
+    }
+}
+
+std::optional<std::uint64_t> TlbCounter::read() const {
+    std::uint64_t count;
+    if (fd < 0 || ::read(fd, &count, sizeof(count)) != sizeof(count)) {
+        return std::nullopt;
+    }
+    return count;
+}
+
+MemoryStats memory_stats(const TlbCounter *tlb) {
+    MemoryStats stats;
+    rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) == 0) {
+        stats.minor_faults = usage.ru_minflt;
+        stats.major_faults = usage.ru_majflt;
+    }
+    std::ifstream smaps("/proc/self/smaps_rollup");
+    std::string key;
+    std::size_t value;
+    while (smaps >> key) {
+        if (key == "AnonHugePages:" && smaps >> value) {
+            stats.huge_page_bytes = value << 10;
+            break;
+        }
+        smaps.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+    }
+    if (tlb) {
+        stats.tlb_misses = tlb->read();
+    }
+    return stats;
+}
+
+#else
+
+void *allocate_zeroed_pages(std::size_t &bytes) {
+    if (bytes == 0) {
+        return nullptr;
+    }
+    void *data = std::calloc(bytes, 1);
+    if (data == nullptr) {
+        throw std::bad_alloc();
+    }
+    return data;
+}
+
+void PageDeleter::operator()(void *data) const { std::free(data); }
+
+TlbCounter::TlbCounter() {}
+TlbCounter::~TlbCounter() {}
+std::optional<std::uint64_t> TlbCounter::read() const { return std::nullopt; }
+
+MemoryStats memory_stats(const TlbCounter *) { return MemoryStats(); }
+
+#endif
+
+std::ostream &operator<<(std::ostream &os, const MemoryStats &stats) {
+    os << stats.minor_faults << " minor and " << stats.major_faults
+       << " major page faults, " << (stats.huge_page_bytes >> 20)
+       << " MB in huge pages, ";
+    if (stats.tlb_misses) {
+        os << *stats.tlb_misses << " dTLB read misses";
+    } else {
+        os << "dTLB misses not available";
+    }
+    return os;
+}
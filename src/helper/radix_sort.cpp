@@ -0,0 +1,122 @@
+#include "helper/radix_sort.hpp"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <thread>
+#include <utility>
+#include <vector>
+
+constexpr std::size_t DIGIT_BITS = 8;
+constexpr std::size_t DIGITS = 1 << DIGIT_BITS;
+constexpr std::size_t SMALL_SIZE = 256;
+
+using Histogram = std::array<std::size_t, DIGITS>;
+
+template <class Key>
+std::size_t digit(Key key, std::size_t shift) {
+    return (key >> shift) & (DIGITS - 1);
+}
+
+template <class Key>
+void lsd_sort(std::span<Key> data, std::size_t key_bits,
+              std::vector<Key> &buffer) {
+    if (data.size() <= SMALL_SIZE) {
+        std::sort(data.begin(), data.end());
+        return;
+    }
+    buffer.resize(data.size());
+    std::span<Key> from = data, to = buffer;
+    for (std::size_t shift = 0; shift < key_bits; shift += DIGIT_BITS) {
+        Histogram offsets{};
+        for (auto key : from) {
+            offsets[digit(key, shift)]++;
+        }
+        std::size_t sum = 0;
+        for (auto &offset : offsets) {
+            sum += std::exchange(offset, sum);
+        }
+        for (auto key : from) {
+            to[offsets[digit(key, shift)]++] = key;
+        }
+        std::swap(from, to);
+    }
+    if (from.data() != data.data()) {
+        std::copy(from.begin(), from.end(), data.begin());
+    }
+}
+
+template <class Key>
+void radix_sort_impl(std::span<Key> data, std::size_t key_bits,
+                     std::size_t threads) {
+    if (key_bits <= DIGIT_BITS || data.size() <= SMALL_SIZE) {
+        std::vector<Key> buffer;
+        lsd_sort(data, key_bits, buffer);
+        return;
+    }
+    std::size_t shift = key_bits - DIGIT_BITS;
+
+    std::vector<Histogram> histograms(threads, Histogram{});
+    std::vector<std::thread> workers;
+    for (std::size_t t = 0; t < threads; t++) {
+        workers.emplace_back([&, t] {
+            auto begin = data.size() * t / threads;
+            auto end = data.size() * (t + 1) / threads;
+            for (std::size_t i = begin; i < end; i++) {
+                histograms[t][digit(data[i], shift)]++;
+            }
+        });
+    }
+    for (auto &&worker : workers) {
+        worker.join();
+    }
+
+    Histogram begin{}, end{};
+    std::size_t sum = 0;
+    for (std::size_t d = 0; d < DIGITS; d++) {
+        begin[d] = sum;
+        for (auto &&histogram : histograms) {
+            sum += histogram[d];
+        }
+        end[d] = sum;
+    }
+
+    // In-place permutation into the partitions (American flag sort)
+    Histogram next = begin;
+    for (std::size_t d = 0; d < DIGITS; d++) {
+        while (next[d] < end[d]) {
+            auto key = data[next[d]];
+            auto key_digit = digit(key, shift);
+            while (key_digit != d) {
+                std::swap(key, data[next[key_digit]++]);
+                key_digit = digit(key, shift);
+            }
+            data[next[d]++] = key;
+        }
+    }
+
+    std::atomic<std::size_t> next_partition = 0;
+    workers.clear();
+    for (std::size_t t = 0; t < threads; t++) {
+        workers.emplace_back([&] {
+            std::vector<Key> buffer;
+            std::size_t d;
+            while ((d = next_partition++) < DIGITS) {
+                lsd_sort(data.subspan(begin[d], end[d] - begin[d]), shift,
+                         buffer);
+            }
+        });
+    }
+    for (auto &&worker : workers) {
+        worker.join();
+    }
+}
+
+void radix_sort(std::span<std::uint64_t> data, std::size_t key_bits,
+                std::size_t threads) {
+    radix_sort_impl(data, key_bits, threads);
+}
+
+void radix_sort(std::span<unsigned __int128> data, std::size_t key_bits,
+                std::size_t threads) {
+    radix_sort_impl(data, key_bits, threads);
+}
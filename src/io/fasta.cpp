@@ -1,34 +1,74 @@
 #include "io/fasta.hpp"
+#include <algorithm>
 #include <cctype>
 
 using namespace io;
 
-constexpr char nucleotide_to_char[] = {'a', 'c', 'g', 't', 'X'};
-
-void KmerWriter::print_nucleotide(int present) {
-    auto n = kmer.last();
-    auto to_print = nucleotide_to_char[n];
-    if (present == PRESENT) {
-        last_one = 0;
-        to_print = std::toupper(to_print);
-    }
-    if (!splice || last_one < kmer.size()) {
-        stream.write(to_print);
-    }
-    last_one++;
+/**
+ * @brief Read the next line of the current sequence, or at most MaxChunkSize
+ * characters of it
+ */
+bool FastaReader::next_chunk() {
+    do {
+        skip_ws();
+        if (stream.eof() || stream.peek() == CommentChar) {
+            return false;
+        }
+        chunk.resize(MaxChunkSize + 1);
+        chunk.resize(stream.get_line_part(chunk.data(), chunk.size()));
+    } while (chunk.empty());
+    position = 0;
+    return true;
 }
 
-void KmerWriter::flush() {
-    int to_print = std::min(kmer.available(), kmer.size() - 1);
-    for (int i = to_print - 1; i >= 0; i--) {
-        add_nucleotide('A');
-        print_nucleotide(NOT_PRESENT);
+bool FastaReader::next_bases(std::string_view &run,
+                             std::vector<Nucleotide> &bases) {
+    while (true) {
+        if (position == chunk.size() && !next_chunk()) {
+            return false;
+        }
+        const char *begin = chunk.data() + position;
+        std::size_t size = chunk.size() - position;
+        bases.resize(size);
+        std::size_t count = encode_nucleotides(begin, size, bases.data());
+        _ambiguous = count == 0;
+        if (_ambiguous) {
+            count = skip_ambiguous(begin, size);
+            std::fill(bases.begin(), bases.begin() + count, N);
+        }
+        if (count == 0) {
+            if (!std::isspace(*begin)) {
+                throw_invalid_nucleotide();
+            }
+            position++;
+            continue;
+        }
+        bases.resize(count);
+        run = std::string_view(begin, count);
+        position += count;
+        return true;
     }
-    kmer.reset();
 }
 
-void KmerWriter::write_header(const std::string &header) {
-    stream.write('>');
-    stream.write(header);
-    stream.write('\n');
+void io::read_runs(FastaReader &in,
+                   const std::vector<RunConsumer *> &consumers) {
+    std::string_view run;
+    std::vector<Nucleotide> bases;
+    while (in.next_sequence()) {
+        for (auto consumer : consumers) {
+            consumer->next_sequence();
+        }
+        while (in.next_bases(run, bases)) {
+            for (auto consumer : consumers) {
+                if (in.ambiguous()) {
+                    consumer->ambiguous(run);
+                } else {
+                    consumer->bases(run, bases);
+                }
+            }
+        }
+        for (auto consumer : consumers) {
+            consumer->end_sequence();
+        }
+    }
 }
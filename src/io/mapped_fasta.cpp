@@ -0,0 +1,90 @@
+#include "io/mapped_fasta.hpp"
+#include <cstring>
+#include <thread>
+
+std::vector<io::Segment> io::find_segments(const MappedFile &file) {
+    std::vector<Segment> segments;
+    const char *data = file.data();
+    const char *end = data + file.size();
+    auto header = (const char *)std::memchr(data, '>', file.size());
+    while (header != nullptr) {
+        auto line_end = (const char *)std::memchr(header, '\n', end - header);
+        if (line_end == nullptr) {
+            break;
+        }
+        auto begin = line_end + 1;
+        header = (const char *)std::memchr(begin, '>', end - begin);
+        segments.push_back({(std::size_t)(begin - data),
+                            (std::size_t)((header ? header : end) - data)});
+    }
+    return segments;
+}
+
+namespace {
+
+/**
+ * @brief Visitor of a range collecting the bases into runs for the consumers
+ */
+class RangeRuns {
+    static constexpr std::size_t MAX_RUN = 4096;
+
+  public:
+    explicit RangeRuns(const std::vector<io::RangeConsumer *> &consumers)
+        : consumers(consumers) {
+        run.reserve(MAX_RUN);
+    }
+    void start(bool first) {
+        flush();
+        for (auto consumer : consumers) {
+            consumer->start(first);
+        }
+    }
+    void base(Nucleotide n, char, bool in_range) {
+        if (in_range != run_in_range || run.size() == MAX_RUN) {
+            flush();
+            run_in_range = in_range;
+        }
+        run.push_back(n);
+    }
+    void ambiguous(std::size_t count, bool in_range) {
+        flush();
+        for (auto consumer : consumers) {
+            consumer->ambiguous(count, in_range);
+        }
+    }
+    void flush() {
+        if (run.empty()) {
+            return;
+        }
+        for (auto consumer : consumers) {
+            consumer->bases(run, run_in_range);
+        }
+        run.clear();
+    }
+
+  private:
+    const std::vector<io::RangeConsumer *> &consumers;
+    std::vector<Nucleotide> run;
+    bool run_in_range = false;
+};
+
+} // namespace
+
+void io::read_ranges(
+        const MappedFile &file, std::size_t context,
+        const std::vector<std::vector<RangeConsumer *>> &consumers) {
+    auto segments = find_segments(file);
+    std::size_t ranges = consumers.size();
+    std::vector<std::thread> workers;
+    for (std::size_t t = 0; t < ranges; t++) {
+        workers.emplace_back([&, t] {
+            RangeRuns runs(consumers[t]);
+            visit_range(file, segments, file.size() * t / ranges,
+                        file.size() * (t + 1) / ranges, context, runs);
+            runs.flush();
+        });
+    }
+    for (auto &&worker : workers) {
+        worker.join();
+    }
+}
@@ -0,0 +1,35 @@
+#include "io/mapped_file.hpp"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace io;
+
+MappedFile::MappedFile(const std::string &path) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return;
+    }
+    struct stat st;
+    if (fstat(fd, &st) == 0) {
+        _open = true;
+        _size = st.st_size;
+    }
+    if (_size > 0) {
+        void *data = mmap(nullptr, _size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data == MAP_FAILED) {
+            _open = false;
+            _size = 0;
+        } else {
+            _data = static_cast<const char *>(data);
+        }
+    }
+    close(fd);
+}
+
+MappedFile::~MappedFile() {
+    if (_data != nullptr) {
+        munmap(const_cast<char *>(_data), _size);
+    }
+}
@@ -12,6 +12,19 @@ bool input_stream::getline(std::string &s) {
 
 bool input_stream::get(char &c) { return stream.get(c).good(); }
 
+/**
+ * @brief Read at most `size` - 1 characters of the current line, without the
+ * line break, and null-terminate them
+ * @return The number of characters read
+ */
+std::size_t input_stream::get_line_part(char *buffer, std::size_t size) {
+    stream.get(buffer, size);
+    if (stream.fail() && !stream.eof()) {
+        stream.clear();
+    }
+    return stream.gcount();
+}
+
 void input_stream::ignore() { stream.ignore(); }
 
 void input_stream::reset() {
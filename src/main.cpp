@@ -1,11 +1,21 @@
 #include "algorithm/approximate_count.hpp"
+#include "algorithm/compare.hpp"
 #include "algorithm/exact.hpp"
+#include "algorithm/filter_sizes.hpp"
 #include "algorithm/first_phase.hpp"
 #include "algorithm/second_phase.hpp"
-#include "hash/murmur_hash.hpp"
+#include "hash/mix_hash.hpp"
 #include "hash/poly_hash.hpp"
 #include "helper/args.hpp"
+#include "helper/kmer_set.hpp"
+#include "sketch/bloom_filter.hpp"
+#include "sketch/counting_bloom_filter.hpp"
+#include "sketch/cuckoo_filter.hpp"
+#include "sketch/dleft_filter.hpp"
+#include <algorithm>
 #include <iostream>
+#include <memory>
+#include <optional>
 #include <ranges>
 #include <vector>
 
@@ -25,26 +35,230 @@ int usage() {
     return 1;
 }
 
-int subcomand_compute(auto &&args) {
-    auto _arg = ComputeArgs::from_cmdline(args.size(), args.data());
-    if (!_arg.has_value()) {
-        return ComputeArgs::usage();
+/**
+ * @brief The compute subcommand for one k-mer size. The passes over the input
+ * are driven from outside, so that all k-mer sizes of a batch share them.
+ */
+class ComputePipeline {
+  public:
+    virtual ~ComputePipeline() = default;
+    /**
+     * @brief Consumer of the pass estimating the number of k-mers
+     */
+    virtual io::RunConsumer &counter() = 0;
+    /**
+     * @brief Consumer of one byte range of the parallel pass estimating the
+     * number of k-mers, instead of counter()
+     */
+    virtual std::unique_ptr<io::RangeConsumer> range_counter() = 0;
+    /**
+     * @brief Merge the estimates of all ranges of the parallel pass, given
+     * the consumers returned by range_counter
+     */
+    virtual void merge_ranges(
+            const std::vector<std::unique_ptr<io::RangeConsumer>> &ranges) = 0;
+    /**
+     * @brief Consumer of the pass of the first phase, valid until second_phase
+     */
+    virtual io::RunConsumer &first_phase() = 0;
+    virtual int second_phase() = 0;
+};
+
+/**
+ * @tparam Sketch The filter of the first phase
+ * @tparam Filter The filter of the second phase
+ */
+template <KmerType KmerT, first_phase::Filter Sketch,
+          second_phase::Filter Filter>
+class BasicComputePipeline : public ComputePipeline {
+    using H = basic_poly_hash_family<KmerT>;
+    using Counter = RangeCounter<mix_hash, KmerT>;
+
+  public:
+    explicit BasicComputePipeline(ComputeArgs &&arg)
+        : arg(std::move(arg)),
+          kmer_repr(this->arg.unidirectional() ? KmerRepr::FORWARD
+                                               : KmerRepr::CANON),
+          count(this->arg.k(), kmer_repr, this->arg.hll_precision()) {}
+    io::RunConsumer &counter() override { return count; }
+    std::unique_ptr<io::RangeConsumer> range_counter() override {
+        return std::make_unique<Counter>(arg.k(), kmer_repr,
+                                         arg.hll_precision());
     }
-    auto arg = _arg.value();
-    auto stats = approximate_count<murmur_hash_family>(arg);
+    void merge_ranges(const std::vector<std::unique_ptr<io::RangeConsumer>>
+                              &ranges) override {
+        auto &total = static_cast<Counter &>(*ranges[0]);
+        for (std::size_t i = 1; i < ranges.size(); i++) {
+            total.merge(static_cast<const Counter &>(*ranges[i]));
+        }
+        counted = total.get_stats();
+    }
+    io::RunConsumer &first_phase() override {
+        auto stats = counted ? *counted : count.get_stats();
+        // The estimate of distinct k-mers may exceed the number of k-mers
+        approximate_duplicates =
+                stats.kmer_count -
+                std::min(stats.kmer_count, stats.approximate_kmer_count);
+        sizes = filter_sizes(arg, stats.approximate_kmer_count,
+                             approximate_duplicates, Filter::bits_per_cell());
+        if (arg.fused()) {
+            filter.emplace(second_phase::create_filter<Filter>(
+                    approximate_duplicates, sizes.second_phase, arg));
+        }
+        return first.emplace(stats.approximate_kmer_count, sizes.first_phase,
+                             arg, filter ? &*filter : nullptr);
+    }
+    int second_phase() override {
+        std::size_t not_present = first->marked_not_present();
+        std::size_t lowercase = first->lowercase_written();
+        if (arg.verbose()) {
+            std::cerr << "[" << Sketch::name() << " fill ratio "
+                      << first->get_filter().fill_ratio() * 100 << "%, "
+                      << not_present << " k-mers marked as not present]\n";
+            if (arg.kmer_cache()) {
+                std::cerr << "[K-mer cache hit rate "
+                          << first->cache_hit_rate() * 100 << "%]\n";
+            }
+        }
+        // Close the first phase output before reading it
+        first.reset();
+        if (filter) {
+            return second_phase::correct_superstring<Filter, KmerT>(*filter,
+                                                                    arg);
+        }
+        if (arg.second_phase() && arg.exact_correction()) {
+            // The filter would take sizes.second_phase bits
+            std::size_t set_size = RollingKmerSet<KmerT>::memory_for(lowercase);
+            if (set_size * 8 <= sizes.second_phase) {
+                return second_phase::compute_superstring<RollingKmerSet<KmerT>,
+                                                         KmerT>(lowercase, 0,
+                                                                arg);
+            }
+            if (arg.verbose()) {
+                std::cerr << "[Exact correction skipped, a set of " << lowercase
+                          << " k-mers takes " << set_size / 1024
+                          << " KB, more than the " << sizes.second_phase / 8192
+                          << " KB of the filter]\n";
+            }
+        }
+        if (arg.second_phase()) {
+            return second_phase::compute_superstring<Filter, KmerT>(
+                    approximate_duplicates, sizes.second_phase, arg);
+        }
+        return 0;
+    }
+
+  private:
+    ComputeArgs arg;
+    KmerRepr kmer_repr;
+    KmerCounter<mix_hash, KmerT> count;
+    std::optional<Stats> counted;
+    std::size_t approximate_duplicates = 0;
+    FilterSizes sizes;
+    std::optional<Filter> filter;
+    std::optional<first_phase::Pipeline<H, KmerT, Sketch, Filter>> first;
+};
+
+/**
+ * @brief The pipeline with the second phase filter selected by the arguments
+ */
+template <KmerType KmerT, first_phase::Filter Sketch>
+std::unique_ptr<ComputePipeline> make_pipeline(ComputeArgs &&arg) {
+    using H = basic_poly_hash_family<KmerT>;
+    if (arg.second_phase_filter() == SecondPhaseFilter::DLEFT) {
+        return std::make_unique<
+                BasicComputePipeline<KmerT, Sketch, RollingDLeftFilter<H>>>(
+                std::move(arg));
+    }
+    if (arg.counter_bits() == 3) {
+        return std::make_unique<BasicComputePipeline<
+                KmerT, Sketch, RollingCountingBloomFilter<H, 3>>>(
+                std::move(arg));
+    }
+    return std::make_unique<
+            BasicComputePipeline<KmerT, Sketch, RollingCountingBloomFilter<H>>>(
+            std::move(arg));
+}
+
+/**
+ * @brief The pipeline with the filters selected by the arguments
+ */
+template <KmerType KmerT>
+std::unique_ptr<ComputePipeline> make_pipeline(ComputeArgs &&arg) {
+    using H = basic_poly_hash_family<KmerT>;
+    if (arg.first_phase_filter() == FirstPhaseFilter::CUCKOO) {
+        return make_pipeline<KmerT, RollingCuckooFilter<H>>(std::move(arg));
+    }
+    return make_pipeline<KmerT, RollingBloomFilter<H>>(std::move(arg));
+}
 
-    auto ret = first_phase::compute_superstring<poly_hash_family>(
-            stats.approximate_kmer_count, arg);
+int compute(const ComputeArgs &arg) {
+    set_huge_pages(arg.huge_pages());
+    std::optional<TlbCounter> tlb;
+    if (arg.verbose()) {
+        tlb.emplace();
+    }
+    std::vector<std::unique_ptr<ComputePipeline>> pipelines;
+    for (auto k : arg.ks()) {
+        pipelines.push_back(with_kmer_size(k, [&](auto kmer_type) {
+            using KmerT = typename decltype(kmer_type)::type;
+            return make_pipeline<KmerT>(arg.for_k(k));
+        }));
+    }
 
-    if (arg.second_phase()) {
-        auto approximate_duplicates = stats.total_length -
-                                      stats.sequence_count * (arg.k() - 1) -
-                                      stats.approximate_kmer_count;
-        return second_phase::compute_superstring<poly_hash_family>(
-                approximate_duplicates, arg);
+    io::FastaReader in(arg.dataset());
+    std::vector<io::RunConsumer *> consumers;
+    if (arg.threads() > 1) {
+        // One parallel pass, every thread feeds a counter of each pipeline
+        std::vector<std::vector<std::unique_ptr<io::RangeConsumer>>> counters(
+                pipelines.size());
+        std::vector<std::vector<io::RangeConsumer *>> ranges(arg.threads());
+        for (std::size_t p = 0; p < pipelines.size(); p++) {
+            for (auto &range : ranges) {
+                counters[p].push_back(pipelines[p]->range_counter());
+                range.push_back(counters[p].back().get());
+            }
+        }
+        io::MappedFile file(arg.dataset());
+        io::read_ranges(file, std::ranges::max(arg.ks()) - 1, ranges);
+        for (std::size_t p = 0; p < pipelines.size(); p++) {
+            pipelines[p]->merge_ranges(counters[p]);
+        }
+    } else {
+        for (auto &&pipeline : pipelines) {
+            consumers.push_back(&pipeline->counter());
+        }
+        io::read_runs(in, consumers);
+        in.reset();
+        consumers.clear();
     }
 
-    return ret;
+    for (auto &&pipeline : pipelines) {
+        consumers.push_back(&pipeline->first_phase());
+    }
+    io::read_runs(in, consumers);
+    if (tlb) {
+        std::cerr << "[After the first phase: " << memory_stats(&*tlb)
+                  << "]\n";
+    }
+
+    for (auto &&pipeline : pipelines) {
+        if (auto ret = pipeline->second_phase()) {
+            return ret;
+        }
+    }
+    if (tlb) {
+        std::cerr << "[In total: " << memory_stats(&*tlb) << "]\n";
+    }
+    return 0;
+}
+
+int subcomand_compute(auto &&args) {
+    auto _arg = ComputeArgs::from_cmdline(args.size(), args.data());
+    if (!_arg.has_value()) {
+        return ComputeArgs::usage();
+    }
+    return compute(_arg.value());
 }
 
 int subcomand_exact(auto &&args) {
@@ -53,7 +267,10 @@ int subcomand_exact(auto &&args) {
         return ExactArgs::usage();
     }
     auto arg = _arg.value();
-    return exact::compute_superstring(arg);
+    return with_kmer_size(arg.k(), [&](auto kmer_type) {
+        using KmerT = typename decltype(kmer_type)::type;
+        return exact::compute_superstring<KmerT>(arg);
+    });
 }
 
 int subcomand_compare(auto &&args) {
@@ -62,8 +279,16 @@ int subcomand_compare(auto &&args) {
         return CompareArgs::usage();
     }
     auto arg = _arg.value();
-    auto acc = exact::compute_accuracy(arg);
+    auto acc = with_kmer_size(arg.k(), [&](auto kmer_type) {
+        using KmerT = typename decltype(kmer_type)::type;
+        return arg.sort() ? compare::sorted_accuracy<KmerT>(arg)
+                          : exact::compute_accuracy<KmerT>(arg);
+    });
     std::cout << acc;
+    if (arg.has_input() && acc.sample_rate >= 1) {
+        std::cout << "Every input kmer represented: "
+                  << (acc.missing_kmers == 0 ? "yes" : "no") << "\n";
+    }
     return 0;
 }
 
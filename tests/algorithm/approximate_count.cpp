@@ -1,10 +1,12 @@
 #include "algorithm/approximate_count.hpp"
+#include "hash/mix_hash.hpp"
 #include "hash/murmur_hash.hpp"
 #include "helper/args.hpp"
 #include "helper/kmer.hpp"
 #include "io/fasta.hpp"
 #include <chrono>
 #include <iostream>
+#include <stdexcept>
 #include <unordered_set>
 
 std::size_t exact_count(io::FastaReader &in, std::size_t K) {
@@ -91,5 +93,18 @@ int main(int argc, char *argv[]) {
 
     std::string path = argv[1];
     std::size_t K = 31;
-    stats_test<murmur_hash_family>(path, K);
+    auto kmer_repr = KmerRepr::CANON;
+    auto sequential = approximate_count(path, K, kmer_repr);
+    auto parallel = approximate_count(
+            path, K, kmer_repr, HyperLogLog<>::default_precision, 4);
+    if (sequential.approximate_kmer_count != parallel.approximate_kmer_count ||
+        sequential.kmer_count != parallel.kmer_count ||
+        sequential.sequence_count != parallel.sequence_count ||
+        sequential.total_length != parallel.total_length) {
+        throw std::runtime_error("Parallel count differs");
+    }
+    std::cout << "Mixer:\n";
+    stats_test<mix_hash>(path, K);
+    std::cout << "MurMur hash:\n";
+    stats_test<murmur_hash>(path, K);
 }
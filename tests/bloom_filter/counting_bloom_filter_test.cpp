@@ -0,0 +1,100 @@
+#include "check.hpp"
+#include "hash/poly_hash.hpp"
+#include "sketch/counting_bloom_filter.hpp"
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+mt19937_64 rng;
+
+/**
+ * @brief Counts far past saturation must stay exact through the overflow
+ * table
+ */
+template <size_t BPC>
+void test_overflow_counters(size_t size, size_t ops) {
+    string name = "BPC = " + to_string(BPC) + ", ";
+    OverflowCounters<BPC> counters(size);
+    vector<size_t> expected(size, 0);
+    uniform_int_distribution<size_t> index_dist(0, size - 1);
+    for (size_t i = 0; i < ops; i++) {
+        auto ind = index_dist(rng);
+        // Increments twice as often as decrements, so that counters saturate
+        if (rng() % 3 != 0) {
+            counters.increment(ind);
+            expected[ind]++;
+        } else if (expected[ind] > 0) {
+            counters.decrement(ind);
+            expected[ind]--;
+        }
+    }
+    size_t saturated = 0;
+    for (size_t i = 0; i < size; i++) {
+        check(counters.test(i) == (expected[i] > 0), name + to_string(i));
+        saturated += expected[i] > (1 << BPC) - 1;
+    }
+    check(saturated > 0, name + "no saturated counter");
+    check(counters.overflows() == saturated, name + "overflow table size");
+
+    for (size_t i = 0; i < size; i++) {
+        for (; expected[i] > 0; expected[i]--) {
+            check(counters.test(i), name + "emptied early " + to_string(i));
+            counters.decrement(i);
+        }
+        check(!counters.test(i), name + "not emptied " + to_string(i));
+    }
+    check(counters.overflows() == 0, name + "overflow table not emptied");
+}
+
+/**
+ * @brief A k-mer inserted into an overfull filter and erased again leaves no
+ * trace, even though its counters saturated
+ */
+void test_no_stuck_counters() {
+    using Filter = RollingCountingBloomFilter<poly_hash_family, 2>;
+    const size_t K = 21;
+    const string ALPHABET = "ACGT";
+    Filter filter(256, 6, K, KmerRepr::FORWARD);
+    string s(K - 1, 'A');
+    for (size_t i = 0; i < 1000; i++) {
+        s += ALPHABET[rng() % 4];
+    }
+    // Insert and erase every k-mer right away, the counters go up and down
+    // together
+    for (size_t round = 0; round < 2; round++) {
+        vector<bool> inserted;
+        filter.reset_hash_family();
+        for (size_t i = 0; i < s.size(); i++) {
+            filter.roll(s[i]);
+            if (i + 1 >= K) {
+                inserted.push_back(!filter.contains_this());
+                filter.insert_this();
+            }
+        }
+        check(filter.overflows() > 0, "no saturated counter");
+        filter.reset_hash_family();
+        for (size_t i = 0, j = 0; i < s.size(); i++) {
+            filter.roll(s[i]);
+            if (i + 1 >= K && inserted[j++]) {
+                filter.erase_this();
+            }
+        }
+        check(filter.overflows() == 0, "overflow table not emptied");
+    }
+    filter.reset_hash_family();
+    for (size_t i = 0; i < s.size(); i++) {
+        filter.roll(s[i]);
+        check(i + 1 < K || !filter.contains_this(), "stuck k-mer");
+    }
+}
+
+int main() {
+    test_overflow_counters<2>(100, 10000);
+    test_overflow_counters<3>(100, 10000);
+    test_overflow_counters<4>(100, 20000);
+    test_no_stuck_counters();
+    cout << "All counting Bloom filter tests passed" << endl;
+}
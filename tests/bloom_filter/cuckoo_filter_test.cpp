@@ -0,0 +1,143 @@
+#include "check.hpp"
+#include "hash/poly_hash.hpp"
+#include "sketch/bloom_filter.hpp"
+#include "sketch/cuckoo_filter.hpp"
+#include <iostream>
+#include <random>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+using namespace std;
+
+using Filter = RollingCuckooFilter<poly_hash_family>;
+
+constexpr string ALPHABET = "ACGT";
+constexpr size_t K = 31;
+
+mt19937_64 rng;
+
+string rand_seq(size_t len) {
+    string s(len, ' ');
+    for (char &c : s) {
+        c = ALPHABET[rng() % ALPHABET.size()];
+    }
+    return s;
+}
+
+/**
+ * @brief Call `f` with the filter rolled to every k-mer of `s` in [begin, end)
+ */
+template <class F>
+void for_each_kmer(Filter &filter, const string &s, size_t begin, size_t end,
+                   F &&f) {
+    filter.reset_hash_family();
+    for (size_t i = 0; i < s.size() && i < end + K - 1; i++) {
+        filter.roll(s[i]);
+        if (i + 1 >= K && i + 1 - K >= begin) {
+            f(s.substr(i + 1 - K, K));
+        }
+    }
+}
+
+void test_insert_erase(size_t n, size_t bits_per_element) {
+    string name = to_string(bits_per_element) + " bits per element: ";
+    auto filter = Filter::for_size(n, bits_per_element * n, K,
+                                   KmerRepr::FORWARD);
+    check(filter.size() <= bits_per_element * n, name + "size");
+    string s = rand_seq(n + K - 1);
+    for_each_kmer(filter, s, 0, n, [&](const string &) {
+        filter.insert_this();
+    });
+    check(filter.dropped() == 0, name + "dropped at 95% load");
+    check(filter.fill_ratio() > 0.9, name + "fill ratio");
+    for_each_kmer(filter, s, 0, n, [&](const string &kmer) {
+        check(filter.contains_this(), name + "inserted " + kmer + " missing");
+    });
+
+    size_t false_positives = 0;
+    string queries = rand_seq(n + K - 1);
+    unordered_set<string> kmers;
+    for (size_t i = 0; i < n; i++) {
+        kmers.insert(s.substr(i, K));
+    }
+    for_each_kmer(filter, queries, 0, n, [&](const string &kmer) {
+        false_positives += filter.contains_this() && !kmers.contains(kmer);
+    });
+    double rate = (double)false_positives / n;
+    check(rate < 1.5 * filter.error_rate(n) + 1e-4,
+          name + "error rate " + to_string(rate));
+    auto bloom = RollingBloomFilter<poly_hash_family>::for_size(
+            n, bits_per_element * n, K, KmerRepr::FORWARD);
+    cout << name << "false positive rate " << rate * 100 << "%, expected "
+         << filter.error_rate(n) * 100 << "%, Bloom filter "
+         << bloom.error_rate(n) * 100 << "%" << endl;
+
+    // Erase the first half, the second half must stay but for the k-mers
+    // sharing a fingerprint and a bucket with an erased one
+    for_each_kmer(filter, s, 0, n / 2, [&](const string &) {
+        filter.erase_this();
+    });
+    size_t lost = 0;
+    for_each_kmer(filter, s, n / 2, n, [&](const string &) {
+        lost += !filter.contains_this();
+    });
+    check(lost < n * filter.error_rate(n) + 10, name + "kept k-mers lost");
+    size_t remaining = 0;
+    for_each_kmer(filter, s, 0, n / 2, [&](const string &) {
+        remaining += filter.contains_this();
+    });
+    check(remaining < n * filter.error_rate(n) + 10,
+          name + "erased k-mers remain");
+    check(filter.fill_ratio() < 0.5, name + "fill ratio after erasing");
+}
+
+void test_overfull(size_t n) {
+    // Room for half of the k-mers, the rest is dropped
+    Filter filter(n / 8, 8, K, KmerRepr::FORWARD);
+    string s = rand_seq(n + K - 1);
+    for_each_kmer(filter, s, 0, n, [&](const string &) {
+        filter.insert_this();
+    });
+    check(filter.dropped() > 0, "nothing dropped");
+    check(filter.fill_ratio() > 0.95, "overfull fill ratio");
+}
+
+/**
+ * @brief The probes of k-mers, taken ahead, must agree with the current k-mer
+ */
+void test_probe(size_t n) {
+    auto filter = Filter::for_size(n, 16 * n, K, KmerRepr::FORWARD);
+    auto reference = Filter::for_size(n, 16 * n, K, KmerRepr::FORWARD);
+    string s = rand_seq(n + K - 1);
+    vector<size_t> probes;
+    for_each_kmer(filter, s, 0, n, [&](const string &) {
+        probes.resize(probes.size() + filter.probe_size());
+        filter.prefetch_this(probes.data() + probes.size() -
+                             filter.probe_size());
+    });
+    // Every k-mer is inserted and queried twice, reusing the saved probes
+    for (size_t round = 0; round < 2; round++) {
+        size_t i = 0;
+        for_each_kmer(reference, s, 0, n, [&](const string &kmer) {
+            auto *probe = probes.data() + i++ * filter.probe_size();
+            bool contains = reference.contains_this();
+            check(filter.contains_probe(probe) == contains,
+                  "probe of " + kmer + " disagrees");
+            if (!contains) {
+                reference.insert_this();
+                filter.insert_probe(probe);
+            }
+        });
+    }
+    check(filter.fill_ratio() == reference.fill_ratio(), "probe fill ratio");
+}
+
+int main() {
+    test_insert_erase(1000000, 10);
+    test_insert_erase(1000000, 16);
+    test_insert_erase(1000000, 24);
+    test_overfull(100000);
+    test_probe(100000);
+    cout << "All cuckoo filter tests passed" << endl;
+}
@@ -0,0 +1,109 @@
+#include "check.hpp"
+#include "hash/poly_hash.hpp"
+#include "sketch/counting_bloom_filter.hpp"
+#include "sketch/dleft_filter.hpp"
+#include <iostream>
+#include <random>
+#include <string>
+#include <unordered_set>
+
+using namespace std;
+
+using Filter = RollingDLeftFilter<poly_hash_family>;
+
+constexpr string ALPHABET = "ACGT";
+constexpr size_t K = 31;
+
+mt19937_64 rng;
+
+string rand_seq(size_t len) {
+    string s(len, ' ');
+    for (char &c : s) {
+        c = ALPHABET[rng() % ALPHABET.size()];
+    }
+    return s;
+}
+
+/**
+ * @brief Call `f` with the filter rolled to every k-mer of `s` in [begin, end)
+ */
+template <class F>
+void for_each_kmer(Filter &filter, const string &s, size_t begin, size_t end,
+                   F &&f) {
+    filter.reset_hash_family();
+    for (size_t i = 0; i < s.size() && i < end + K - 1; i++) {
+        filter.roll(s[i]);
+        if (i + 1 >= K && i + 1 - K >= begin) {
+            f(s.substr(i + 1 - K, K));
+        }
+    }
+}
+
+void test_insert_erase(size_t n) {
+    auto filter = Filter::for_memory(n, 20 * n, K, KmerRepr::FORWARD);
+    string s = rand_seq(n + K - 1);
+    for_each_kmer(filter, s, 0, n, [&](const string &) {
+        filter.insert_this();
+    });
+    check(filter.overflows() == 0, "overflow at 80% load");
+    for_each_kmer(filter, s, 0, n, [&](const string &kmer) {
+        check(filter.contains_this(), "inserted " + kmer + " missing");
+    });
+
+    // The memory of a counting Bloom filter of the default 10 counters per
+    // element, at a higher error rate
+    auto cbf = RollingCountingBloomFilter<poly_hash_family>::for_memory(
+            n, 40 * n, K, KmerRepr::FORWARD);
+    check(2 * filter.memory() <= cbf.memory() + 64 * 2, "memory");
+    check(filter.error_rate(n) < cbf.error_rate(n), "expected error rate");
+
+    size_t false_positives = 0;
+    string queries = rand_seq(n + K - 1);
+    unordered_set<string> kmers;
+    for (size_t i = 0; i < n; i++) {
+        kmers.insert(s.substr(i, K));
+    }
+    for_each_kmer(filter, queries, 0, n, [&](const string &kmer) {
+        false_positives += filter.contains_this() && !kmers.contains(kmer);
+    });
+    double rate = (double)false_positives / n;
+    check(rate < 2 * filter.error_rate(n) + 1e-4,
+          "error rate " + to_string(rate));
+    cout << "False positive rate " << rate * 100 << "%, expected "
+         << filter.error_rate(n) * 100 << "%" << endl;
+
+    // Erase the first half, the second half must stay but for the k-mers
+    // sharing a fingerprint and a bucket with an erased one
+    for_each_kmer(filter, s, 0, n / 2, [&](const string &) {
+        filter.erase_this();
+    });
+    size_t lost = 0;
+    for_each_kmer(filter, s, n / 2, n, [&](const string &) {
+        lost += !filter.contains_this();
+    });
+    check(lost < n * filter.error_rate(n), "kept k-mers lost");
+    size_t remaining = 0;
+    for_each_kmer(filter, s, 0, n / 2, [&](const string &) {
+        remaining += filter.contains_this();
+    });
+    check(remaining < n / 1000, "erased k-mers remain");
+}
+
+void test_overflow(size_t n) {
+    // Two buckets of 32 cells for many more k-mers
+    Filter filter(1, K, KmerRepr::FORWARD);
+    string s = rand_seq(n + K - 1);
+    for_each_kmer(filter, s, 0, n, [&](const string &) {
+        filter.insert_this();
+    });
+    check(filter.overflows() > 0, "no overflow");
+    for_each_kmer(filter, s, 0, n, [&](const string &kmer) {
+        check(filter.contains_this(), "overflowed " + kmer + " missing");
+    });
+}
+
+int main() {
+    test_insert_erase(1000000);
+    test_overflow(1000);
+    cout << "All d-left filter tests passed" << endl;
+}
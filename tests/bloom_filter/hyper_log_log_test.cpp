@@ -0,0 +1,92 @@
+#include "check.hpp"
+#include "hash/mix_hash.hpp"
+#include "hash/murmur_hash.hpp"
+#include "sketch/hyper_log_log.hpp"
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+constexpr size_t K = 31;
+
+mt19937_64 rng;
+
+/**
+ * @brief Estimate the number of k-mers of a random sequence, distinct up to a
+ * few collisions of 62-bit values
+ */
+template <Hash H, KmerType KmerT = Kmer>
+void test_estimate(size_t n, size_t precision, size_t k = K) {
+    HyperLogLog<H> hll(KmerRepr::FORWARD, precision);
+    check(hll.precision() == precision, "precision");
+    KmerT kmer(k);
+    for (size_t i = 0; i < n + k - 1; i++) {
+        kmer.roll((Nucleotide)(rng() % 4));
+        if (kmer.available() >= k) {
+            hll.update(kmer);
+            // Repeated k-mers must not count
+            hll.update(kmer);
+        }
+    }
+    double error = abs((double)hll.query() - (double)n) / n;
+    double standard_error = 1.04 / sqrt((double)(1 << precision));
+    cout << "n = " << n << ", precision " << precision << ": error "
+         << error * 100 << "%, standard error " << standard_error * 100
+         << "%" << endl;
+    check(error < 4 * standard_error,
+          to_string(n) + " k-mers at precision " + to_string(precision));
+}
+
+/**
+ * @brief Sketches of parts of a set merged must equal the sketch of the set
+ */
+void test_merge(size_t n, size_t parts) {
+    vector<HyperLogLog<>> sketches(parts, HyperLogLog<>(KmerRepr::FORWARD));
+    HyperLogLog<> all(KmerRepr::FORWARD);
+    Kmer kmer(K);
+    for (size_t i = 0; i < n + K - 1; i++) {
+        kmer.roll((Nucleotide)(rng() % 4));
+        if (kmer.available() >= K) {
+            all.update(kmer);
+            sketches[i % parts].update(kmer);
+        }
+    }
+    for (size_t i = 1; i < parts; i++) {
+        sketches[0].merge(sketches[i]);
+    }
+    check(sketches[0].query() == all.query(), "merged estimate");
+    // Merging is idempotent
+    sketches[0].merge(all);
+    check(sketches[0].query() == all.query(), "merged twice");
+
+    HyperLogLog<> other(KmerRepr::FORWARD, 12);
+    bool thrown = false;
+    try {
+        all.merge(other);
+    } catch (const invalid_argument &) {
+        thrown = true;
+    }
+    check(thrown, "merged different precisions");
+}
+
+int main() {
+    HyperLogLog<> empty(KmerRepr::FORWARD);
+    check(empty.query() == 0, "empty");
+    check(empty.precision() == 14, "default precision");
+    HyperLogLog<> clamped(KmerRepr::FORWARD, 30);
+    check(clamped.precision() == 18, "clamped precision");
+
+    for (size_t precision : {10, 14, 18}) {
+        for (size_t n : {10, 1000, 100000, 3000000}) {
+            test_estimate<mix_hash>(n, precision);
+            test_estimate<murmur_hash>(n, precision);
+        }
+    }
+    test_merge(1000000, 4);
+    // Wide k-mers are folded to 64 bits
+    test_estimate<mix_hash, WideKmer>(1000000, 14, 45);
+    cout << "All HyperLogLog tests passed" << endl;
+}
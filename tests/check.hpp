@@ -0,0 +1,17 @@
+#ifndef CHECK_HPP
+#define CHECK_HPP
+
+#include <stdexcept>
+#include <string>
+
+/**
+ * @brief Fail a test with `message` unless `condition` holds, also in release
+ * builds where assert does nothing
+ */
+inline void check(bool condition, const std::string &message) {
+    if (!condition) {
+        throw std::runtime_error("Test failed: " + message);
+    }
+}
+
+#endif
@@ -0,0 +1,70 @@
+#include "check.hpp"
+#include "helper/bitset.hpp"
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+mt19937_64 rng;
+
+vector<bool> random_bits(DynamicBitset &bitset, double density) {
+    bernoulli_distribution dist(density);
+    vector<bool> bits(bitset.size());
+    for (size_t i = 0; i < bits.size(); i++) {
+        if ((bits[i] = dist(rng))) {
+            bitset.set(i);
+        }
+    }
+    return bits;
+}
+
+void test_bulk(size_t size) {
+    DynamicBitset a(size), b(size);
+    auto bits_a = random_bits(a, 0.3);
+    auto bits_b = random_bits(b, 0.6);
+    size_t count_a = 0;
+    for (size_t i = 0; i < size; i++) {
+        check(a.test(i) == bits_a[i], "test " + to_string(i));
+        count_a += bits_a[i];
+    }
+    check(a.count() == count_a, "count of size " + to_string(size));
+    check(a.words().size() * 64 >= size && a.words().size() * 64 < size + 64,
+          "word count of size " + to_string(size));
+
+    DynamicBitset both(size), either(size);
+    either |= a;
+    either |= b;
+    both |= a;
+    both &= b;
+    size_t count_both = 0, count_either = 0;
+    for (size_t i = 0; i < size; i++) {
+        check(either.test(i) == (bits_a[i] || bits_b[i]), "or " + to_string(i));
+        check(both.test(i) == (bits_a[i] && bits_b[i]), "and " + to_string(i));
+        count_both += bits_a[i] && bits_b[i];
+        count_either += bits_a[i] || bits_b[i];
+    }
+    check(both.count() == count_both, "count of and");
+    check(either.count() == count_either, "count of or");
+
+    for (size_t i = 0; i < size; i++) {
+        a.reset(i);
+    }
+    check(a.count() == 0, "count after reset");
+}
+
+int main() {
+    for (size_t size : {1, 63, 64, 65, 1000, 1 << 20}) {
+        test_bulk(size);
+    }
+    bool thrown = false;
+    try {
+        DynamicBitset a(10), b(11);
+        a |= b;
+    } catch (const invalid_argument &) {
+        thrown = true;
+    }
+    check(thrown, "merge of different sizes");
+    cerr << "DynamicBitset OK" << endl;
+}
@@ -0,0 +1,55 @@
+#include "check.hpp"
+#include "helper/counting_bitset.hpp"
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+mt19937_64 rng;
+
+template <size_t BPC>
+void test_random(size_t size, size_t ops) {
+    const size_t max_count = (1 << BPC) - 1;
+    CountingBitset<BPC> bitset(size);
+    vector<size_t> expected(size, 0);
+    uniform_int_distribution<size_t> index_dist(0, size - 1);
+    uniform_int_distribution<int> op_dist(0, 2);
+    for (size_t i = 0; i < ops; i++) {
+        auto ind = index_dist(rng);
+        switch (op_dist(rng)) {
+        case 0:
+        case 1:
+            bitset.increment(ind);
+            expected[ind] = min(expected[ind] + 1, max_count);
+            break;
+        case 2:
+            bitset.decrement(ind);
+            expected[ind] -= expected[ind] > 0;
+            break;
+        }
+    }
+    string name = "BPC = " + to_string(BPC) + ", index ";
+    for (size_t i = 0; i < size; i++) {
+        check(bitset.get(i) == expected[i], name + to_string(i));
+        check(bitset.test(i) == (expected[i] > 0), name + to_string(i));
+        check(bitset.is_stuck(i) == (expected[i] == max_count),
+              name + to_string(i));
+    }
+    for (size_t i = 0; i < size; i++) {
+        bitset.set(i, i);
+        check(bitset.get(i) == min(i, max_count), "set " + name + to_string(i));
+    }
+}
+
+int main() {
+    for (size_t size : {1, 7, 100}) {
+        test_random<4>(size, 10000);
+        test_random<5>(size, 10000);
+        test_random<8>(size, 100000);
+    }
+    test_random<4>(100000, 1000000);
+    test_random<8>(100000, 1000000);
+    cerr << "CountingBitset OK" << endl;
+}
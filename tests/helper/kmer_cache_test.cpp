@@ -0,0 +1,49 @@
+#include "check.hpp"
+#include "helper/kmer_cache.hpp"
+#include <iostream>
+#include <random>
+#include <string>
+#include <unordered_set>
+
+using namespace std;
+
+mt19937_64 rng;
+
+/**
+ * @brief A hit must always be a key seen before
+ */
+template <class Key>
+void test_random(size_t ops, uint64_t universe) {
+    KmerCache<Key> cache;
+    unordered_set<uint64_t> seen;
+    uniform_int_distribution<uint64_t> key_dist(0, universe);
+    size_t hits = 0;
+    for (size_t i = 0; i < ops; i++) {
+        auto key = key_dist(rng);
+        bool hit = cache.test_and_set(key);
+        check(!hit || seen.contains(key), "hit of unseen " + to_string(key));
+        hits += hit;
+        seen.insert(key);
+    }
+    check(cache.hit_rate() == (double)hits / ops, "hit rate");
+}
+
+void test_repeats() {
+    KmerCache<> cache;
+    // A tandem repeat of period 7: every key recurs after 7 keys
+    size_t hits = 0;
+    for (size_t i = 0; i < 7000; i++) {
+        hits += cache.test_and_set(1000 + i % 7);
+    }
+    check(hits == 7000 - 7, "repeats missed");
+    check(!cache.test_and_set(~0ULL) && !cache.test_and_set(~0ULL),
+          "empty key hit");
+}
+
+int main() {
+    test_random<uint64_t>(1000000, 10000);
+    test_random<unsigned __int128>(1000000, 1000);
+    test_random<uint64_t>(1000000, ~0ULL);
+    test_repeats();
+    cout << "All KmerCache tests passed" << endl;
+}
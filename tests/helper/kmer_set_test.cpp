@@ -0,0 +1,120 @@
+#include "check.hpp"
+#include "helper/kmer_set.hpp"
+#include <iostream>
+#include <random>
+#include <string>
+#include <unordered_set>
+
+using namespace std;
+
+mt19937_64 rng;
+
+void test_random(size_t reserved, size_t ops, uint64_t universe) {
+    KmerSet set(reserved);
+    unordered_set<uint64_t> expected;
+    uniform_int_distribution<uint64_t> key_dist(0, universe);
+    uniform_int_distribution<int> op_dist(0, 2);
+    for (size_t i = 0; i < ops; i++) {
+        auto key = key_dist(rng);
+        switch (op_dist(rng)) {
+        case 0:
+        case 1:
+            check(set.insert(key) == expected.insert(key).second,
+                  "insert " + to_string(key));
+            break;
+        case 2:
+            check(set.erase(key) == (expected.erase(key) > 0),
+                  "erase " + to_string(key));
+            break;
+        }
+        check(set.size() == expected.size(), "size after op " + to_string(i));
+    }
+    for (uint64_t key = 0; key <= min<uint64_t>(universe, 100000); key++) {
+        check(set.contains(key) == expected.contains(key),
+              "contains " + to_string(key));
+    }
+}
+
+void test_reserve(size_t count) {
+    KmerSet set(count);
+    auto capacity = set.capacity();
+    for (uint64_t key = 0; key < count; key++) {
+        check(set.insert(key * 4 + 1), "reserve insert " + to_string(key));
+    }
+    check(set.capacity() == capacity, "rehash within reserved capacity");
+    for (uint64_t key = 0; key < count; key++) {
+        check(set.contains(key * 4 + 1), "reserve contains " + to_string(key));
+        check(!set.contains(key * 4 + 2), "reserve absent " + to_string(key));
+    }
+}
+
+void test_wide(size_t count) {
+    using u128 = unsigned __int128;
+    BasicKmerSet<u128> set;
+    // Keys differing only in the high half must not collide
+    for (uint64_t key = 0; key < count; key++) {
+        check(set.insert((u128)key << 64 | 7), "wide insert " + to_string(key));
+    }
+    check(set.size() == count, "wide size");
+    for (uint64_t key = 0; key < count; key++) {
+        check(set.contains((u128)key << 64 | 7), "wide contains");
+        check(!set.contains((u128)key << 64 | 8), "wide absent");
+    }
+}
+
+/**
+ * @brief The rolling set stores canonical k-mers, a k-mer and its reverse
+ * complement are the same element
+ */
+void test_rolling(size_t length) {
+    const size_t K = 21;
+    const string ALPHABET = "ACGT";
+    string s;
+    for (size_t i = 0; i < length; i++) {
+        s += ALPHABET[rng() % 4];
+    }
+    string rc(s.rbegin(), s.rend());
+    for (char &c : rc) {
+        c = ALPHABET[3 - ALPHABET.find(c)];
+    }
+    auto set = RollingKmerSet<BasicKmer<K>>::for_memory(length, 0, K,
+                                                        KmerRepr::CANON);
+    auto for_each_kmer = [&](const string &seq, auto &&f) {
+        set.reset_hash_family();
+        for (size_t i = 0; i < seq.size(); i++) {
+            set.roll(char_to_nucleotide(seq[i]));
+            if (i + 1 >= K) {
+                f(seq.substr(i + 1 - K, K));
+            }
+        }
+    };
+    unordered_set<string> kmers;
+    for_each_kmer(s, [&](const string &kmer) {
+        set.insert_this();
+        kmers.insert(kmer);
+    });
+    check(set.size() <= kmers.size(), "rolling size");
+    for_each_kmer(rc, [&](const string &kmer) {
+        check(set.contains_this(), "reverse complement " + kmer);
+        set.erase_this();
+    });
+    check(set.size() == 0, "rolling erase");
+}
+
+int main() {
+    test_random(0, 100000, 1000);
+    test_random(0, 100000, 100000);
+    test_random(1000, 100000, -1);
+    cerr << "Random operations OK" << endl;
+
+    for (size_t count : {1, 15, 16, 17, 1000, 123457}) {
+        test_reserve(count);
+    }
+    cerr << "Reserved capacity OK" << endl;
+
+    test_wide(100000);
+    cerr << "Wide keys OK" << endl;
+
+    test_rolling(10000);
+    cerr << "Rolling k-mer set OK" << endl;
+}
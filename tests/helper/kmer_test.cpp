@@ -1,7 +1,9 @@
+#include "check.hpp"
 #include "helper/kmer.hpp"
 #include <cassert>
 #include <iostream>
 #include <string>
+#include <vector>
 
 std::uint64_t reverse(std::uint64_t data, std::size_t K) {
     data = (data >> 2 & 0x3333333333333333ULL) |
@@ -142,6 +144,105 @@ bool init_test(size_t K) {
     return res;
 }
 
+bool full_word_test(size_t N) {
+    std::string s = random_dna(N);
+    Kmer kmer(32);
+    for (size_t i = 0; i < N; i++) {
+        kmer.roll(s[i]);
+        if (i >= 31 &&
+            kmer.data(KmerRepr::FORWARD) !=
+                    Kmer(s.substr(i - 31, 32)).data(KmerRepr::FORWARD)) {
+            std::cerr << "Full word mismatch at position " << i << "\n";
+            return false;
+        }
+    }
+    return true;
+}
+
+bool encode_test(size_t N) {
+    std::string s = random_dna(N);
+    for (size_t i = 0; i < N; i += 7) {
+        s[i] = std::tolower(s[i]);
+    }
+    std::vector<Nucleotide> bases(N);
+    if (encode_nucleotides(s.data(), N, bases.data()) != N) {
+        return false;
+    }
+    for (size_t i = 0; i < N; i++) {
+        if (bases[i] != char_to_nucleotide(s[i])) {
+            std::cerr << "Encode mismatch at position " << i << "\n";
+            return false;
+        }
+    }
+    for (char invalid : {'n', 'X', 'U', ' ', '\n', '>'}) {
+        auto t = s;
+        t[N / 2 + 3] = invalid;
+        if (encode_nucleotides(t.data(), N, bases.data()) != N / 2 + 3) {
+            std::cerr << "Invalid character '" << invalid << "' accepted\n";
+            return false;
+        }
+    }
+    return true;
+}
+
+bool ambiguous_test(size_t N) {
+    std::string s(N, 'N');
+    for (size_t i = 0; i < N; i += 5) {
+        s[i] = "nRyK"[i % 4];
+    }
+    if (skip_ambiguous(s.data(), N) != N || char_to_nucleotide('n') != ::N) {
+        return false;
+    }
+    for (size_t i = 0; i < N; i += 3) {
+        auto t = s;
+        t[i] = "AcGt"[i % 4];
+        if (skip_ambiguous(t.data(), N) != i) {
+            std::cerr << "Ambiguous run end not found at position " << i
+                      << "\n";
+            return false;
+        }
+    }
+    return true;
+}
+
+template <std::size_t K>
+bool fixed_test(size_t N) {
+    std::string s = random_dna(N);
+    BasicKmer<K> fixed;
+    Kmer kmer(K);
+    for (size_t i = 0; i < N; i++) {
+        fixed.roll(s[i]);
+        kmer.roll(s[i]);
+        if (fixed.data(KmerRepr::CANON) != kmer.data(KmerRepr::CANON) ||
+            fixed.available() != kmer.available() || !(Kmer(fixed) == kmer)) {
+            std::cerr << "Fixed k-mer mismatch for K = " << K << "\n";
+            return false;
+        }
+    }
+    return true;
+}
+
+bool wide_test(size_t N, size_t K) {
+    std::string s = random_dna(N);
+    WideKmer kmer(K);
+    for (size_t i = 0; i < N; i++) {
+        kmer.roll(s[i]);
+        if (i + 1 < K) {
+            continue;
+        }
+        auto sub = s.substr(i + 1 - K, K);
+        auto forward = WideKmer(sub).data(KmerRepr::FORWARD);
+        auto backward = WideKmer(reverse(sub)).data(KmerRepr::FORWARD);
+        if (kmer.data(KmerRepr::FORWARD) != forward ||
+            kmer.data(KmerRepr::CANON) != std::min(forward, backward)) {
+            std::cerr << "Wide k-mer mismatch for K = " << K
+                      << " at position " << i << "\n";
+            return false;
+        }
+    }
+    return true;
+}
+
 int main() {
     for (size_t i = 1; i < 31; i++) {
         assert(reverse_test(100, i));
@@ -154,4 +255,17 @@ int main() {
         for (size_t i = 0; i < 100; i++)
             assert(init_test(k));
     }
+    check(full_word_test(1000), "full word k-mers");
+    check(fixed_test<15>(1000), "fixed k-mers of 15 bases");
+    check(fixed_test<31>(1000), "fixed k-mers of 31 bases");
+    check(fixed_test<32>(1000), "fixed k-mers of 32 bases");
+    for (size_t k : {1, 31, 33, 47, 63, 64}) {
+        check(wide_test(1000, k),
+              "wide k-mers of " + std::to_string(k) + " bases");
+    }
+    for (size_t n = 40; n < 100; n++) {
+        check(encode_test(n), "encoding " + std::to_string(n) + " bases");
+        check(ambiguous_test(n),
+              "ambiguous runs of " + std::to_string(n) + " bases");
+    }
 }
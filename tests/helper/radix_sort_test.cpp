@@ -0,0 +1,62 @@
+#include "helper/radix_sort.hpp"
+#include <algorithm>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+mt19937_64 rng;
+
+void test_sort(size_t n, size_t key_bits, size_t threads) {
+    vector<uint64_t> data(n);
+    uint64_t mask = key_bits == 64 ? ~0ULL : (1ULL << key_bits) - 1;
+    for (auto &x : data) {
+        x = rng() & mask;
+    }
+    auto expected = data;
+    sort(expected.begin(), expected.end());
+    radix_sort(data, key_bits, threads);
+    if (data != expected) {
+        throw runtime_error("Radix sort test failed: n = " + to_string(n) +
+                            ", key_bits = " + to_string(key_bits) +
+                            ", threads = " + to_string(threads));
+    }
+}
+
+void test_sort_wide(size_t n, size_t key_bits, size_t threads) {
+    using u128 = unsigned __int128;
+    vector<u128> data(n);
+    for (auto &x : data) {
+        x = (u128)rng() << 64 | rng();
+        if (key_bits < 128) {
+            x &= ((u128)1 << key_bits) - 1;
+        }
+    }
+    auto expected = data;
+    sort(expected.begin(), expected.end());
+    radix_sort(data, key_bits, threads);
+    if (data != expected) {
+        throw runtime_error("Wide radix sort test failed: n = " +
+                            to_string(n) + ", key_bits = " +
+                            to_string(key_bits));
+    }
+}
+
+int main() {
+    for (size_t n : {0, 1, 100, 257, 10000, 1000000}) {
+        for (size_t key_bits : {2, 8, 9, 42, 62, 64}) {
+            for (size_t threads : {1, 3}) {
+                test_sort(n, key_bits, threads);
+            }
+        }
+    }
+    for (size_t n : {0, 100, 100000}) {
+        for (size_t key_bits : {66, 100, 128}) {
+            test_sort_wide(n, key_bits, 3);
+        }
+    }
+    cerr << "Radix sort OK" << endl;
+}